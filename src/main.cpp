@@ -2,14 +2,42 @@
 #include "util/graphs.hpp"
 #include "util/profile.hpp"
 #include "util/isomorphism.hpp"
+#include "util/enumerators.hpp"
+#include "util/thread_pool.hpp"
+#include "util/pipeline.hpp"
+#include "util/striped_map.hpp"
+#include "util/result_cache.hpp"
 #include "solv/branching.hpp"
-#include "math.h"
+#include "solv/batch_solver.hpp"
+#include "solv/catalogue.hpp"
+#include "solv/kernelization.hpp"
 #include <algorithm>
+#include <atomic>
+#include <sstream>
 
 #define num_edges(x) ((x*(x-1))/2)
 
-string profile_names[] = { "A", "B", "C", "D", "E", "F", "G", "H" };
-string internal_names[] = { "0", "1", "2", "3" , "4", "5", "6", "7", "8" };
+// profiles of graphs with less vertices are not worth distributing over threads
+#define PARALLEL_PROFILE_MIN_VERTICES 32
+// number of attachments of profile vertices to an internal graph that are tried in one batch
+#define ATTACHMENT_CHUNK_SIZE 4096
+// number of batches that fit between two stages of the pipeline
+#define PIPELINE_QUEUE_SIZE 64
+// number of graphs whose profiles are computed in one task in the 'all' action
+#define PROFILE_CHUNK_SIZE 4096
+// number of graphs whose profiles are handed to the batch solver at once
+#define PACKED_BATCH_SIZE 256
+// number of candidates after which the order of the checks of profile entries is adapted to the statistics
+#define CHECK_ORDER_INTERVAL 256
+// largest number of internal vertices for which the attachments are bounded using the VC numbers of all
+// 2^n induced subgraphs of the internal graph
+#define ATTACHMENT_BOUND_MAX_VERTICES 20
+// largest number of profile vertices the packed kernels are specialized for
+#define PACKED_MAX_PROFILE 8
+
+// the largest number of profile vertices: a profile has 2^p entries and every solver thread keeps
+// a cache of that size, so 2^20 entries (a few MB each) is where we stop
+#define MAX_PROFILE_VERTICES 20
 
 
 /******** argument parsing *************/
@@ -17,20 +45,44 @@ string internal_names[] = { "0", "1", "2", "3" , "4", "5", "6", "7", "8" };
 typedef map<string, vector<string> >  arg_map;
 const std::pair<string, unsigned char> _requires_params[] = {
   { "graph", 1 },
+  { "batch", 1 },
   { "enum", 0 },
   { "profile",  1 },
   { "all", 0 },
+  { "apply", 3 }, // rule file, input graph, output graph
   { "-n", 1 }, // number of internal vertices
-  { "-p", 1 } // number of profile vertices (heaps)
+  { "-p", 1 }, // number of profile vertices (heaps)
+  { "-t", 1 }, // number of threads
+  { "-u", 0 }, // output one representative per isomorphism class
+  { "-d", 1 }, // maximum degree
+  { "--connected", 0 }, // only connected graphs
+  { "--all-border-attached", 0 }, // only graphs in which each profile vertex has a neighbor
+  { "--no-isolated", 0 }, // only graphs in which each internal vertex has a neighbor
+  { "--cache", 1 }, // directory of the caches
+  { "--no-cache", 0 }, // don't use the result cache
+  { "--generic", 0 }, // don't use the packed kernels
+  { "--stats", 0 } // print the queue metrics and the rejection statistics
 };
 
 void usage(const char* progname, std::ostream& o){
   o << "usage: " << progname << " graph <file to read> [more opts]" << std::endl;
+  o << "       " << progname << " batch <file listing graph files> [more opts] "<< std::endl;
   o << "       " << progname << " profile <file to read> [more opts] "<< std::endl;
   o << "       " << progname << " all [more opts] "<< std::endl;
   o << "       " << progname << " enum [more opts] "<< std::endl;
-  o << "more opts: " << " -n x\t <int>\t search for graphs with x internal vertices (default: 4, max: 8)"<< std::endl;
-  o << "           " << " -p x\t <int>\t size of the profile (default: 4, max: 8)"<< std::endl;
+  o << "       " << progname << " apply <rule file> <graph file to reduce> <file to write the kernel to> [-t x]"<< std::endl;
+  o << "more opts: " << " -n x\t <int>\t search for graphs with x internal vertices (default: 4)"<< std::endl;
+  o << "           " << " -p x\t <int>\t size of the profile (default: 4)"<< std::endl;
+  o << "           " << " -t x\t <int>\t number of threads (default: number of cores)"<< std::endl;
+  o << "           " << " -u  \t      \t output only one graph per isomorphism class (fixing the profile vertices) and the size of the class"<< std::endl;
+  o << "           " << " -d x\t <int>\t only generate graphs of maximum degree x (profile vertices included)"<< std::endl;
+  o << "           " << " --connected          \t only generate connected graphs (profile vertices included)"<< std::endl;
+  o << "           " << " --all-border-attached\t only generate graphs in which each profile vertex has a neighbor"<< std::endl;
+  o << "           " << " --no-isolated        \t only generate graphs in which each internal vertex has a neighbor"<< std::endl;
+  o << "           " << " --cache x            \t <dir>\t keep the vertex cover table, the graph catalogues and the results of \"graph\" in x (default: "<<vc::cache_directory()<<")"<< std::endl;
+  o << "           " << " --no-cache           \t don't look up or store the results of \"graph\" in the cache"<< std::endl;
+  o << "           " << " --generic            \t compute profiles on graphs even if there are packed kernels for -n and -p"<< std::endl;
+  o << "           " << " --stats              \t print the queue metrics and rejection statistics to stderr (\"graph\" and \"batch\" mode)"<< std::endl;
   exit(1);
 }
 
@@ -59,211 +111,563 @@ arg_map parse_args(int argc, char** argv){
 
 using namespace vc;
 
-// first 'profile_vertices' ids get the profile_names, rest gets the internal names
+// the name of the i-th profile vertex: A, B, ..., Z, then A1, B1, ..., Z1, A2, ...
+string profile_name(const uint i){
+  const string letter(1, 'A' + i % 26);
+  return i < 26 ? letter : letter + to_string(i / 26);
+}
+
+// first 'profile_vertices' ids get the profile names, the rest gets the internal names 0, 1, ...
 string get_name_by_id(const uint id, const uint profile_vertices){
   if(id < profile_vertices)
-    return profile_names[id];
+    return profile_name(id);
   else
-    return internal_names[id - profile_vertices];
+    return to_string(id - profile_vertices);
+}
+
+// the ids of 'count' border vertices, numbered consecutively starting at 'first'
+vector<uint> consecutive_ids(const uint first, const uint count){
+  vector<uint> result(count);
+  for(uint i = 0; i < count; ++i) result[i] = first + i;
+  return result;
 }
 
-// construct the graph with given edges
-graph get_graph(const AdjMatrix& edges, const uint profile_vertices){
-  const uint num_verts(edges.size());
+// look up the ids of the border vertices A, B, ... of g by name
+vector<uint> get_border_ids(graph& g, const uint profile_vertices){
+  vector<uint> result(profile_vertices);
+  for(uint i = 0; i < profile_vertices; ++i){
+    const vertex_p v(g.find_vertex_by_name(profile_name(i)));
+    if(v == g.vertices.end()) FAIL("border vertex "<<profile_name(i)<<" not found in the input graph");
+    result[i] = v->id;
+  }
+  return result;
+}
+
+// construct the graph with the edges of the given code
+// the vertex with id i is vertex i of the layout, so the border vertices are 0, 1, ..., profile_vertices - 1
+template<class Code>
+graph get_graph(const edge_layout& layout, const Code& code, const uint profile_vertices){
+  const uint num_verts(layout.num_vertices());
   graph g;
   vector<vertex_p> vertices(num_verts);
   // vertices are A B C D v 0 1 2 3 ...
   for(uint id = 0; id < num_verts; ++id)
-    vertices[id] = g.add_vertex_fast(get_name_by_id(id, profile_vertices));
+    vertices[id] = g.add_vertex_fast(id, get_name_by_id(id, profile_vertices));
+
+  for(uint bit = 0; bit < layout.size(); ++bit)
+    if(code.test(bit)) g.add_edge_fast(vertices[layout[bit].first], vertices[layout[bit].second]);
 
-  for(uint i = 0; i < num_verts; ++i)
-    for(uint j = max(i, profile_vertices); j < num_verts; ++j)
-      if(edges[i][j]) g.add_edge_fast(vertices[i], vertices[j]);
-  
   DEBUG3(cout << "done constructing new graph"<<endl);
   return g;
 }
 
-// add profile vertices to the graph g containing internal vertices
-// add edges between the internal and the profile vertices according to 'edges'
-void add_profile_to_internal(graph& g, const AdjMatrix& edges){
-  const uint internal_vertices = edges.size();
-  const uint profile_vertices = edges[0].size();
+// add profile vertices to the graph g containing internal vertices (with ids 0, 1, ...)
+// add edges between the internal and the profile vertices according to the attachment layout and code
+// the profile vertices get the ids following the internal ones
+template<class Code>
+void add_profile_to_internal(graph& g, const edge_layout& layout, const Code& code, const uint profile_vertices){
+  const uint internal_vertices = layout.num_vertices() - profile_vertices;
 
-  vector<vertex_p> internals(internal_vertices);
-  vector<vertex_p> profiles(profile_vertices);
-
-  // get the internal vertices by name
-  for(uint i = 0; i < internal_vertices; ++i)
-    internals[i] = g.find_vertex_by_name(internal_names[i]);
   // get the profile vertices by adding them
   for(uint i = 0; i < profile_vertices; ++i)
-    profiles[i] = g.add_vertex_fast(profile_names[i]);
+    g.add_vertex_fast(internal_vertices + i, profile_name(i));
 
-  for(uint i = 0; i < internal_vertices; ++i)
-    for(uint j = 0; j < profile_vertices; ++j)
-      if(edges[i][j]) g.add_edge_fast(internals[i], profiles[j]);
+  for(uint bit = 0; bit < layout.size(); ++bit)
+    if(code.test(bit))
+      g.add_edge_fast(g.find_vertex_by_id(layout[bit].first), g.find_vertex_by_id(layout[bit].second));
 }
 
-// advance to the next adjacency matrix by basically adding 1 to the bitset represented by AdjMatrix
-bool advance_to_next_graph(AdjMatrix& edges, const uint profile_vertices){
-  const uint num_verts = edges.size();
-  uint j = 0;
-  for(uint i = 0; i < num_verts; ++i){
-    for(j = max(i + 1, profile_vertices); j < num_verts; ++j)
-      if(!edges[i][j]) {
-        edges[i][j] = true; // if a 0 was found, make it 1
-        break;
-      } else edges[i][j] = false; // all trailing 1's become 0
-    if(j < num_verts) break;
-  }
- 
-  DEBUG3(cout << "adj-matrix now:"<<endl;
-      for(uint i = 0; i < num_verts; ++i) cout<<edges[i]<<endl; );
- 
-  // if all digits are 1, then return false, there is no successor
-  return (j < num_verts);
-}
-
-// advance to the next bipartite adjacency matrix
-bool advance_to_next_bipartite_graph(AdjMatrix& edges){
-  const uint part1 = edges.size();
-  const uint part2 = edges[0].size();
-  uint j = 0;
-  for(uint i = 0; i < part1; ++i){
-    for(j = 0; j < part2; ++j)
-      if(!edges[i][j]) {
-        edges[i][j] = true; // if a 0 was found, make it 1
-        break;
-      } else edges[i][j] = false; // all trailing 1's become 0
-    if(j < part2) break;
+atomic<uint> vc_counter(0);
+// profile entries that the bounds of their neighbors in the lattice settled without solving anything
+atomic<uint64_t> settled_entries(0);
+
+// the equivalence classes of the 'all' action, mapping profiles to the codes of their graphs,
+// which many threads insert into at once
+template<class Code>
+using profile_class_map = striped_map<profile_t, vector<Code>, profile_hasher>;
+
+// compute the entry of the profile of g for the border subset given by the bits of index
+// (bit i set = all outside-neighbors of border[i] are in the VC)
+// the entry is known to be between 'lower' and 'upper' (if it's at least 'upper', then 'upper' is returned)
+// if a pool is given and g is large, the branching itself is spread over the pool
+uint get_profile_entry(const graph& g,
+                       const vector<uint>& border,
+                       const uint index,
+                       thread_pool* pool = NULL,
+                       const uint lower = 0,
+                       const uint upper = UINT_MAX){
+  DEBUG4(cout << "profile containment in VC: "<<index<<endl);
+  graph gprime(g);
+  solution_size_t s;
+  for(uint i = 0; i < border.size(); ++i){
+    // get i'th vertex (it's a meta-vertex)
+    const vertex_p X = gprime.find_vertex_by_id(border[i]);
+    // if all of X are in the VC, delete v
+    if(index & (1 << i)) gprime.delete_vertex(X); else // else select all of N(X)
+      for(edge_p e = X->adj_list.begin(); e != X->adj_list.end();){
+        vertex_p u(e->head);
+        ++e;
+        select_vertex(gprime, u, s);
+      }
   }
- 
-  DEBUG4(cout << "adj-matrix now:"<<endl;
-      for(uint i = 0; i < part1; ++i) cout<<edges[i]<<endl; );
- 
-  // if all digits are 1, then return false, there is no successor
-  return (j != part2);
+  // solve the rest of g, whose VC number is between lower - |s| and upper - |s|
+  const uint rest_lower(lower - min(lower, s.size()));
+  const uint rest_upper(upper == UINT_MAX ? UINT_MAX : upper - min(upper, s.size()));
+  if(pool && gprime.vertices.size() >= PARALLEL_PROFILE_MIN_VERTICES)
+    s.count += run_parallel_branching_algo(gprime, *pool, rest_upper);
+  else
+    s.count += run_bounded_branching_algo(gprime, rest_lower, rest_upper);
+  DEBUG4(cout << "got size-"<<s.size()<<" solution: " << s<< endl);
+  return s.size();
 }
 
-// advance to the next border vertex cover by adding 1 to the border bitset
-// return the inverse of the carry flag (the last border was not 111...1)
-bool advance_to_next_border(vector<bool>& border){
-  for(uint i = 0; i < border.size(); ++i)
-    if(border[i]) border[i] = false; else {
-      border[i] = true;
-      return true;
-    }
-  return false;
+// the degrees of the border vertices of g, which bound the differences between neighboring profile entries
+// (if two border vertices are adjacent, deleting one changes the neighborhood of the other, so we return no bounds)
+vector<uint> border_degrees(const graph& g, const vector<uint>& border){
+  vector<uint> result(border.size(), 0);
+  for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v){
+    const vector<uint>::const_iterator i(find(border.begin(), border.end(), v->id));
+    if(i == border.end()) continue;
+    for(edge_pc e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
+      if(find(border.begin(), border.end(), e->head->id) != border.end()) return vector<uint>();
+    result[i - border.begin()] = v->degree();
+  }
+  return result;
 }
 
+// compute entry 'index' of the profile of g, searching only between the bounds implied by the valid entries of the cache
+uint lattice_profile_entry(const graph& g,
+                           const vector<uint>& border,
+                           const uint index,
+                           const vector<uint>& degrees,
+                           const profile_cache& cache,
+                           thread_pool* pool = NULL){
+  const pair<uint, uint> bounds(cache.bounds(index, degrees));
+  if(bounds.first >= bounds.second){
+    ++settled_entries;
+    return bounds.second;
+  }
+  return get_profile_entry(g, border, index, pool, bounds.first, bounds.second);
+}
 
-uint vc_counter = 0;
+// the same if we only care whether the entry is 'expected', so the search is cut off above it
+// return false if we only found out that the entry is not 'expected' (then 'value' is meaningless),
+// otherwise the entry is stored in 'value'
+bool lattice_profile_entry(const graph& g,
+                           const vector<uint>& border,
+                           const uint index,
+                           const vector<uint>& degrees,
+                           const profile_cache& cache,
+                           const int expected,
+                           uint& value,
+                           thread_pool* pool = NULL,
+                           uint* solves = NULL){
+  const pair<uint, uint> bounds(cache.bounds(index, degrees));
+  // the bounds may rule out the expected entry without solving anything
+  if(expected < (int)bounds.first || (bounds.second != UINT_MAX && expected > (int)bounds.second)) return false;
+  if(bounds.first == bounds.second){
+    ++settled_entries;
+    value = bounds.first;
+    return true;
+  }
+  // an entry above expected + 1 is as bad as expected + 1
+  const uint cap(min(bounds.second, (uint)expected + 1));
+  value = get_profile_entry(g, border, index, pool, bounds.first, cap);
+  if(solves) ++*solves;
+  return value < cap || cap == bounds.second;
+}
 
 // check if the profile of g matches (+/- offset) the given profile p
-bool profile_equal(const graph& g, const profile_t& p, const uint profile_vertices, const uint vc_num){
-  // profile border: 1 = 'all neighbors are in the VC'
-  vector<bool> profile_border(profile_vertices);
+// the border vertices of g are given by their ids
+// entries of g's profile that are still valid in the cache are not recomputed, the others are computed
+// in lattice order, each bounded by its neighbors
+// if a pool is given and g is large, the entries of each level of the lattice are computed in parallel,
+// stopping as soon as one mismatches (the solvers only keep all threads busy if there are enough
+// internal graphs, and candidates this large leave few of them)
+// if statistics are given, the outcome of each check of the sequential path is recorded in them
+bool profile_equal(const graph& g,
+                   const profile_t& p,
+                   const vector<uint>& border,
+                   const uint vc_num,
+                   profile_cache& cache,
+                   thread_pool* pool = NULL,
+                   rejection_statistics* stats = NULL){
   // get the offset using the vc_num of g
   const int offset = (int)vc_num - p.back();
-  uint index = 0;
 
   DEBUG3(cout << "computing profile"<<endl);
-  ++vc_counter;
-  if(vc_counter % 500000 == 0) DEBUG1(cerr<<"crunched "<<vc_counter/1000<<"k graphs"<<endl);
-
-  do{
-    DEBUG4(cout << "profile containment in VC: "<<profile_border<<endl);
-    graph gprime(g);
-    solution_t s;
-    for(uint i = 0; i < profile_vertices; ++i){
-      // get i'th vertex (it's a meta-vertex)
-      const vertex_p X = gprime.find_vertex_by_name(get_name_by_id(i, profile_vertices));
-      // if all of X are in the VC, delete v
-      if(profile_border[i]) gprime.delete_vertex(X); else // else select all of N(X)
-        for(edge_p e = X->adj_list.begin(); e != X->adj_list.end();){
-          vertex_p u(e->head);
-          ++e;
-          select_vertex(gprime, u, s);
-        }
+  const uint crunched(++vc_counter);
+  if(crunched % 500000 == 0) DEBUG1(cerr<<"crunched "<<crunched/1000<<"k graphs"<<endl);
+
+  // if all border vertices are in, only the VC of the internal graph is left, which we know
+  if(!cache.valid.back()){
+    cache.values.back() = vc_num;
+    cache.valid.back() = true;
+  }
+  const vector<uint> degrees(border_degrees(g, border));
+
+  if(pool && g.vertices.size() >= PARALLEL_PROFILE_MIN_VERTICES){
+    // first check the entries we know already
+    for(uint index = 0; index < p.size(); ++index)
+      if(cache.valid[index] && (int)cache.values[index] != (int)p[index] + offset) return false;
+
+    for(uint level = 0; level <= border.size(); ++level){
+      atomic<bool> mismatch(false);
+      vector<char> computed(p.size(), false);
+      {
+        task_group tasks(*pool);
+        for(uint index = 0; index < p.size(); ++index)
+          if(!cache.valid[index] && (uint)__builtin_popcount(index) == level)
+            tasks.run([&, index](){
+                // don't bother if another entry mismatched already
+                if(mismatch) return;
+                // the neighbors in the lattice are on other levels, so no one writes to them now
+                const int expected((int)p[index] + offset);
+                uint value;
+                if(!lattice_profile_entry(g, border, index, degrees, cache, expected, value, pool)){
+                  mismatch = true;
+                  return;
+                }
+                cache.values[index] = value;
+                computed[index] = true;
+                if((int)value != expected) mismatch = true;
+              });
+        tasks.wait();
+      }
+      for(uint index = 0; index < p.size(); ++index)
+        if(computed[index]) cache.valid[index] = true;
+      if(mismatch) return false;
+    }
+    return true;
+  }
+
+  uint solves = 0;
+  for(const uint index : cache.order){
+    const int expected((int)p[index] + offset);
+    bool mismatch = false;
+    if(!cache.valid[index]){
+      uint value;
+      if(lattice_profile_entry(g, border, index, degrees, cache, expected, value, NULL, &solves)){
+        cache.values[index] = value;
+        cache.valid[index] = true;
+      } else mismatch = true;
     }
-    // solve the rest of g
-    s += run_branching_algo(gprime);
-    DEBUG4(cout << "got size-"<<s.size()<<" solution: " << s<< endl);
     // if the solution size (offset by 'offset') does not match the profile, return failure
-    if(s.size() != p[index++] + offset) return false;
-  } while(advance_to_next_border(profile_border));
+    mismatch = mismatch || (int)cache.values[index] != expected;
+    if(stats) stats->record_check(index, mismatch);
+    if(mismatch){
+      if(stats) stats->record_candidate(false, solves);
+      return false;
+    }
+  }
+  if(stats) stats->record_candidate(true, solves);
   return true;
 }
 
+// bring all entries of the cached profile of g up to date and return it
+// the border vertices of g are given by their ids
+// entries that are still valid in the cache are not recomputed, the others are computed in lattice order,
+// each bounded by its neighbors
+// if a pool is given and g is large, the entries of each level of the lattice are computed in parallel
+const profile_t& update_profile(const graph& g, const vector<uint>& border, profile_cache& cache, thread_pool* pool = NULL){
+  DEBUG3(cout << "computing profile"<<endl);
+  const uint crunched(++vc_counter);
+  if(crunched % 100000 == 0) DEBUG1(cerr<<"crunched "<<crunched/1000<<"k graphs"<<endl);
+
+  const vector<uint> degrees(border_degrees(g, border));
+  if(pool && g.vertices.size() >= PARALLEL_PROFILE_MIN_VERTICES){
+    for(uint level = 0; level <= border.size(); ++level){
+      vector<char> computed(cache.values.size(), false);
+      {
+        task_group tasks(*pool);
+        for(uint index = 0; index < cache.values.size(); ++index)
+          if(!cache.valid[index] && (uint)__builtin_popcount(index) == level)
+            tasks.run([&, index](){
+                cache.values[index] = lattice_profile_entry(g, border, index, degrees, cache, pool);
+                computed[index] = true;
+              });
+        tasks.wait();
+      }
+      for(uint index = 0; index < cache.values.size(); ++index)
+        if(computed[index]) cache.valid[index] = true;
+    }
+  } else {
+    for(const uint index : cache.order)
+      if(!cache.valid[index]){
+        // save the optimal solution size in values[index]
+        cache.values[index] = lattice_profile_entry(g, border, index, degrees, cache);
+        cache.valid[index] = true;
+      }
+  }
+  DEBUG3(cout << "profile for graph "<<g<<":"<<endl);
+  DEBUG3(cout << cache.values<<endl);
+  return cache.values;
+}
+
+profile_t get_profile(const graph& g, const vector<uint>& border, thread_pool* pool = NULL){
+  profile_cache cache(1u << border.size());
+  return update_profile(g, border, cache, pool);
+}
 
+// add the edge between the vertices with ids u and v to g if it's not there, otherwise remove it
+void toggle_edge(graph& g, const uint u, const uint v){
+  const vertex_p x(g.find_vertex_by_id(u));
+  const vertex_p y(g.find_vertex_by_id(v));
+  const edge_p e(find_edge(x, y));
+  if(e == x->adj_list.end()) g.add_edge_fast(x, y); else g.delete_edge(e);
+}
 
-profile_t get_profile(const graph& g, const uint profile_vertices){
-  profile_t result(pow(2, profile_vertices));
-  // profile border: 1 = 'all neighbors are in the VC'
-  vector<bool> profile_border(profile_vertices);
-  uint index = 0;
+// the packed adjacency of g, whose vertices have the ids 0, 1, ..., 7
+uint64_t packed_graph(const graph& g){
+  uint64_t result = 0;
+  for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v)
+    for(edge_pc e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
+      result |= (uint64_t)1 << (8 * v->id + e->head->id);
+  return result;
+}
 
-  DEBUG3(cout << "computing profile"<<endl);
-  ++vc_counter;
-  if(vc_counter % 100000 == 0) DEBUG1(cerr<<"crunched "<<vc_counter/1000<<"k graphs"<<endl);
-
-  do{
-    DEBUG4(cout << "profile containment in VC: "<<profile_border<<endl);
-    graph gprime(g);
-    solution_t s;
-    for(uint i = 0; i < profile_vertices; ++i){
-      // get i'th vertex
-      vertex_p v = gprime.find_vertex_by_name(get_name_by_id(i, profile_vertices));
-      // if not all of v's neighbors are in the VC, use v (but don't put it into a solution)
-      if(profile_border[i]) gprime.delete_vertex(v); else // else select all
-        for(edge_p e = v->adj_list.begin(); e != v->adj_list.end();){
-          vertex_p u(e->head);
-          ++e;
-          select_vertex(gprime, u, s);
-        }
+// computes the profiles of batches of candidates with N internal and P profile vertices using the batch solver
+// candidate c consists of the packed internal graph internal[c] and profile vertices whose neighborhoods
+// in the internal graph are neighbors[c][0], neighbors[c][1], ...
+// entry S of its profile is |N(B - S)| plus the VC number of the internal graph minus N(B - S)
+// (N and P are template parameters, so all loops have fixed lengths the compiler can unroll)
+template<uint N, uint P>
+struct packed_profiler {
+  static const uint profile_size = 1u << P;
+  // input
+  uint64_t internal[PACKED_BATCH_SIZE];
+  byte neighbors[PACKED_BATCH_SIZE][P];
+  // output
+  uint profiles[PACKED_BATCH_SIZE][profile_size];
+
+  uint64_t residuals[PACKED_BATCH_SIZE * profile_size];
+  uint8_t vc_numbers[PACKED_BATCH_SIZE * profile_size];
+
+  // compute the profiles of the first 'count' candidates
+  void compute(const size_t count){
+    byte selected[profile_size];
+    for(size_t c = 0; c < count; ++c){
+      // selected[T] = neighborhood of the profile vertices in T, that is, N(B - S) for S = complement of T
+      selected[0] = 0;
+      for(uint T = 1; T < profile_size; ++T) selected[T] = selected[T & (T - 1)] | neighbors[c][__builtin_ctz(T)];
+      for(uint S = 0; S < profile_size; ++S){
+        const byte sel(selected[(profile_size - 1) & ~S]);
+        residuals[c * profile_size + S] = packed_induced(internal[c], ~sel);
+        profiles[c][S] = __builtin_popcount(sel);
+      }
     }
-    s += run_branching_algo(gprime);
-    DEBUG4(cout << "got size-"<<s.size()<<" solution: " << s<< endl);
-    // save the optimal solution size in result[index]
-    result[index++] = s.size();
-  } while(advance_to_next_border(profile_border));
-  DEBUG3(cout << "profile for graph "<<g<<":"<<endl);
-  DEBUG3(cout << result<<endl);
+    solve_batch<N>(residuals, count * profile_size, vc_numbers);
+    for(size_t c = 0; c < count; ++c)
+      for(uint S = 0; S < profile_size; ++S)
+        profiles[c][S] += vc_numbers[c * profile_size + S];
+    vc_counter += count;
+  }
+};
+
+// compute the profiles of the graphs with the given codes with the batch solver and
+// add the codes to the equivalence classes of their profiles
+template<uint N, uint P>
+void packed_profiles_of_codes(const edge_layout& layout,
+                              const vector<edge_code<1> >& codes,
+                              profile_class_map<edge_code<1> >& equiv_class){
+  typedef packed_profiler<N, P> profiler_t;
+  // too large for the stack
+  unique_ptr<profiler_t> profiler(new profiler_t);
+  uint64_t rows[N + P];
+  for(size_t first = 0; first < codes.size(); first += PACKED_BATCH_SIZE){
+    const size_t count(min((size_t)PACKED_BATCH_SIZE, codes.size() - first));
+    for(size_t c = 0; c < count; ++c){
+      // the vertices are A B C D ... 0 1 2 3 ..., so shift out the border from the adjacency rows
+      layout.decode(codes[first + c], rows);
+      uint64_t packed = 0;
+      for(uint i = 0; i < N; ++i)
+        packed |= ((rows[P + i] >> P) & 0xff) << (8 * i);
+      profiler->internal[c] = packed;
+      for(uint j = 0; j < P; ++j) profiler->neighbors[c][j] = rows[j] >> P;
+    }
+    profiler->compute(count);
+    for(size_t c = 0; c < count; ++c){
+      const edge_code<1> code(codes[first + c]);
+      const profile_t p(profiler->profiles[c], profiler->profiles[c] + profiler_t::profile_size);
+      equiv_class.update(p, [code](vector<edge_code<1> >& members){ members.push_back(code); });
+    }
+  }
+}
+
+// compute the profiles of the graphs with the given codes and
+// add the codes to the equivalence classes of their profiles
+template<class Code>
+void profiles_of_codes(const edge_layout& layout,
+                       const uint profile_vertices,
+                       const vector<Code>& codes,
+                       profile_class_map<Code>& equiv_class){
+  if(codes.empty()) return;
+  const vector<uint> border(consecutive_ids(0, profile_vertices));
+  // the current graph, updated one edge at a time
+  Code current(codes.front());
+  graph g(get_graph(layout, current, profile_vertices));
+  profile_cache cache(1u << profile_vertices);
+  for(const Code& code : codes){
+    // toggle the edges in which the next graph differs from the current one
+    for(Code diff = current ^ code; !diff.empty(); diff.clear_lowest()){
+      const pair<uint, uint>& flipped(layout[diff.lowest()]);
+      toggle_edge(g, flipped.first, flipped.second);
+      // an edge at a border vertex only matters for the profile entries in which this border vertex is not in the VC
+      if(flipped.first < profile_vertices) cache.invalidate_border(flipped.first); else cache.invalidate_all();
+    }
+    current = code;
+    DEBUG5(cout << "current graph "<< g<< endl);
+    // get the profile of 'g' and add 'g' to the equivalence class of this profile
+    equiv_class.update(update_profile(g, border, cache), [&code](vector<Code>& members){ members.push_back(code); });
+  }
+}
+
+// the codes of an edge counter range, in Gray code order
+template<class Code>
+vector<Code> gray_codes(const edge_counter& range){
+  vector<Code> result;
+  result.reserve(range.size());
+  for(edge_counter::iterator k = range.begin(); k != range.end(); ++k) result.push_back(Code(k.gray()));
   return result;
 }
 
-void output_all_profiles(const uint internal_vertices, const uint profile_vertices){
-  unordered_map<profile_t, list<graph>, profile_hasher > equiv_class;
+// the same as equiv_class_fixed_internal for internal graphs with N vertices and P profile vertices, using the batch solver
+// the neighborhoods of the P profile vertices in the internal graph, given by an attachment code
+// (bit i * P + j of the code stands for the edge between internal vertex i and profile vertex j)
+template<uint P>
+inline void packed_attachments(const edge_code<1>& code, byte* neighbors){
+  for(uint j = 0; j < P; ++j) neighbors[j] = 0;
+  for(uint64_t bits = code.word(0); bits; bits &= bits - 1){
+    const uint bit(__builtin_ctzll(bits));
+    neighbors[bit % P] |= 1 << (bit / P);
+  }
+}
+
+template<uint N, uint P>
+void packed_equiv_class_fixed_internal(const graph& g, 
+                                       const profile_t& target,
+                                       const vector<edge_code<1> >& codes,
+                                       vector<edge_code<1> >& matches,
+                                       const uint vc_num){
+  typedef packed_profiler<N, P> profiler_t;
+  const int offset = (int)vc_num - target.back();
+  const edge_layout layout(edge_layout::attachments(N, P));
+  unique_ptr<profiler_t> profiler(new profiler_t);
+  for(uint c = 0; c < PACKED_BATCH_SIZE; ++c) profiler->internal[c] = packed_graph(g);
+  for(size_t first = 0; first < codes.size(); first += PACKED_BATCH_SIZE){
+    const size_t count(min((size_t)PACKED_BATCH_SIZE, codes.size() - first));
+    for(size_t c = 0; c < count; ++c) packed_attachments<P>(codes[first + c], profiler->neighbors[c]);
+    profiler->compute(count);
+    for(size_t c = 0; c < count; ++c){
+      uint index = 0;
+      while(index < profiler_t::profile_size && (int)profiler->profiles[c][index] == (int)target[index] + offset) ++index;
+      if(index == profiler_t::profile_size){
+        DEBUG1(graph gprime(g); add_profile_to_internal(gprime, layout, codes[first + c], P);
+               cerr<<"found "; gprime.print_edges(cerr));
+        matches.push_back(codes[first + c]);
+      }
+    }
+  }
+}
+
+// the kernels for candidates with fixed numbers of internal and profile vertices
+// compute the profiles of the attachments 'codes' of the profile vertices to g with the batch solver
+// entry S of the profile of codes[c] goes to profiles[c * 2^P + S]
+template<uint N, uint P>
+void packed_profiles_fixed_internal(const graph& g, const vector<edge_code<1> >& codes, vector<uint>& profiles){
+  typedef packed_profiler<N, P> profiler_t;
+  unique_ptr<profiler_t> profiler(new profiler_t);
+  for(uint c = 0; c < PACKED_BATCH_SIZE; ++c) profiler->internal[c] = packed_graph(g);
+  profiles.resize(codes.size() * profiler_t::profile_size);
+  for(size_t first = 0; first < codes.size(); first += PACKED_BATCH_SIZE){
+    const size_t count(min((size_t)PACKED_BATCH_SIZE, codes.size() - first));
+    for(size_t c = 0; c < count; ++c) packed_attachments<P>(codes[first + c], profiler->neighbors[c]);
+    profiler->compute(count);
+    for(size_t c = 0; c < count; ++c)
+      copy(profiler->profiles[c], profiler->profiles[c] + profiler_t::profile_size, profiles.begin() + (first + c) * profiler_t::profile_size);
+  }
+}
+
+// the kernels work on single-word codes, so the packed_kernels<Code> for wider codes are never filled in
+template<class Code>
+struct packed_kernels {
+  void (*profiles_of_codes)(const edge_layout&, const vector<Code>&, profile_class_map<Code>&);
+  void (*equiv_class_fixed_internal)(const graph&, const profile_t&, const vector<Code>&, vector<Code>&, const uint);
+  void (*profiles_fixed_internal)(const graph&, const vector<Code>&, vector<uint>&);
+};
+typedef packed_kernels<edge_code<1> > narrow_packed_kernels;
+
+#define PACKED_KERNELS(N, P) { packed_profiles_of_codes<N, P>, packed_equiv_class_fixed_internal<N, P>, packed_profiles_fixed_internal<N, P> }
+#define PACKED_KERNEL_ROW(N) { PACKED_KERNELS(N, 1), PACKED_KERNELS(N, 2), PACKED_KERNELS(N, 3), PACKED_KERNELS(N, 4), \
+                               PACKED_KERNELS(N, 5), PACKED_KERNELS(N, 6), PACKED_KERNELS(N, 7), PACKED_KERNELS(N, 8) }
+// packed_kernel_table[n - 1][p - 1] are the kernels for n internal and p profile vertices
+const narrow_packed_kernels packed_kernel_table[PACKED_MAX_VERTICES][PACKED_MAX_PROFILE] = {
+  PACKED_KERNEL_ROW(1), PACKED_KERNEL_ROW(2), PACKED_KERNEL_ROW(3), PACKED_KERNEL_ROW(4),
+  PACKED_KERNEL_ROW(5), PACKED_KERNEL_ROW(6), PACKED_KERNEL_ROW(7), PACKED_KERNEL_ROW(8)
+};
+
+// the kernels for codes of type Code, if there are any
+template<class Code>
+inline const packed_kernels<Code>* kernels_for(const narrow_packed_kernels* kernels) { return NULL; }
+template<>
+inline const narrow_packed_kernels* kernels_for<edge_code<1> >(const narrow_packed_kernels* kernels) { return kernels; }
+
+
+// if 'kernels' is given, the profiles are computed by its packed kernels, otherwise on graphs
+// only graphs satisfying the constraints are considered (without constraints, all graphs are counted through,
+// which needs a layout of at most MAX_COUNTED_EDGES edges)
+template<class Code>
+void output_all_profiles(const uint internal_vertices,
+                         const uint profile_vertices,
+                         thread_pool& pool,
+                         const packed_kernels<Code>* kernels,
+                         const enumeration_constraints& constraints){
+  profile_class_map<Code> equiv_class;
   // for each graph with n vertices, get its profile
   // (that is, 2^border solution sizes, depending on whether the neighbors of the first 4 vertices are selected or not)
 
   // forbit edges between A, B, C, D
   const uint num_verts = internal_vertices + profile_vertices;
-  AdjMatrix edges(num_verts, vector<bool>(num_verts)); // wastes space, but simplifies the program
-  for(uint i = 0; i < num_verts; ++i)
-    for(uint j = max(i, profile_vertices); j < num_verts; ++j) edges[i][j] = false;
-  
-
-  DEBUG4(cout << "done initializing edges"<<endl);
-  do {
-    // get the graph based on 'edges'
-    graph g(get_graph(edges, profile_vertices));
-    DEBUG3(cout << "got new graph"<< endl);
-    DEBUG5(cout << "created graph "<< g<< endl);
-    // get the profile of 'g'
-    profile_t p(get_profile(g, profile_vertices));
-    // add 'g' to the equivalence class of this profile
-    equiv_class[p].push_back(g);
-  } while(advance_to_next_graph(edges, profile_vertices));
+  const edge_layout layout(num_verts, profile_vertices);
+  {
+    task_group tasks(pool);
+    // compute the profiles of some codes, which the task owns
+    const auto process = [&layout, profile_vertices, &equiv_class, kernels](const vector<Code>& codes){
+      if(kernels)
+        kernels->profiles_of_codes(layout, codes, equiv_class);
+      else
+        profiles_of_codes(layout, profile_vertices, codes, equiv_class);
+    };
+    if(constraints.none()){
+      // count through all graphs, each task expanding its own range
+      const edge_counter candidates(layout.size());
+      const uint chunks((candidates.size() + PROFILE_CHUNK_SIZE - 1) / PROFILE_CHUNK_SIZE);
+      for(const edge_counter& chunk : candidates.split(chunks))
+        tasks.run([chunk, process](){ process(gray_codes<Code>(chunk)); });
+    } else {
+      // the constrained graphs are few, so collect them first and then distribute them
+      vector<bool> border(num_verts, false);
+      for(uint i = 0; i < profile_vertices; ++i) border[i] = true;
+      const vector<Code> candidates(constrained_enumerator<Code>(layout, constraints, border).all());
+      DEBUG1(cerr << candidates.size() << " graphs satisfy the constraints"<<endl);
+      for(size_t first = 0; first < candidates.size(); first += PROFILE_CHUNK_SIZE){
+        const vector<Code> chunk(candidates.begin() + first, candidates.begin() + min(first + PROFILE_CHUNK_SIZE, candidates.size()));
+        tasks.run([chunk, process](){ process(chunk); });
+      }
+    }
+  }
 
+  // sort the classes and their members, so the output does not depend on the scheduling
+  vector<pair<profile_t, vector<Code> > > classes(equiv_class.extract());
+  sort(classes.begin(), classes.end());
   // output the equivalence classes
   cout << "EQUIVALENCE CLASSES:"<<endl;
-  for(auto m = equiv_class.begin(); m != equiv_class.end(); ++m){
+  for(auto m = classes.begin(); m != classes.end(); ++m){
     cout << "================ "<< m->first << " ============================= "<<endl;
+    sort(m->second.begin(), m->second.end());
     // go through the list of graphs
-    for(auto l = m->second.begin(); l != m->second.end(); ++l)
-      l->print_edges(cout);
+    for(const Code& code : m->second)
+      get_graph(layout, code, profile_vertices).print_edges(cout);
   }
 
 }
@@ -278,104 +682,546 @@ void generate_and_apply(const graph& internal,
                         void* apply(list<graph>&, const graph&, const profile_t, const uint)){
 }
 
-void print_if_equal(list<graph>& eq_class,
-                    const graph& g,
-                    const profile_t& p,
-                    const uint profile_vertices,
-                    const uint vc_num){
-  if(profile_equal(g, p, profile_vertices, vc_num)){
+// if the profile of g matches p, record its code in 'matches'
+template<class Code>
+void record_if_equal(vector<Code>& matches,
+                     const Code& code,
+                     const graph& g,
+                     const profile_t& p,
+                     const vector<uint>& border,
+                     const uint vc_num,
+                     profile_cache& cache,
+                     thread_pool* pool = NULL,
+                     rejection_statistics* stats = NULL){
+  if(profile_equal(g, p, border, vc_num, cache, pool, stats)){
     DEBUG1(cerr<<"found "; g.print_edges(cerr));
-    eq_class.push_back(g);
+    matches.push_back(code);
   }
 }
 
 
 
-// add all graphs of the equivalence class of the target profile, agreeing on a fixed internal graph
+// cheap necessary conditions that the attachment of the profile vertices to an internal graph
+// has to satisfy for the candidate to have the target profile (+ offset), checked without solving anything
+class attachment_filter {
+  const uint internal_vertices;
+  const uint profile_vertices;
+  // entry S of the candidate's profile is |N(B - S)| + vc(internal graph - N(B - S)), where B are the
+  // profile vertices, and the second term is between 0 and vc_num, which bounds |N(B - S)| from both sides
+  vector<int> min_neighbors, max_neighbors;
+  // profile vertices that need a neighbor, since the target depends on whether they are in the VC
+  uint required;
+public:
+  attachment_filter(const profile_t& target, const uint _internal_vertices, const uint _profile_vertices, const uint vc_num):
+    internal_vertices(_internal_vertices), profile_vertices(_profile_vertices),
+    min_neighbors(target.size()), max_neighbors(target.size()), required(0)
+  {
+    const int offset = (int)vc_num - target.back();
+    for(uint index = 0; index < target.size(); ++index){
+      min_neighbors[index] = (int)target[index] - (int)target.back();
+      max_neighbors[index] = (int)target[index] + offset;
+      for(uint i = 0; i < profile_vertices; ++i)
+        if(!(index & (1 << i)) && target[index] != target[index | (1 << i)]) required |= 1 << i;
+    }
+  }
+
+  template<class Code>
+  bool operator()(const Code& code) const {
+    // neighbors[j] = set of internal vertices adjacent to profile vertex j (bit i * profile_vertices + j of code)
+    uint64_t neighbors[8 * sizeof(uint)] = {};
+    for(uint i = 0; i < internal_vertices; ++i)
+      for(uint j = 0; j < profile_vertices; ++j)
+        if(code.test(i * profile_vertices + j)) neighbors[j] |= (uint64_t)1 << i;
+
+    for(uint j = 0; j < profile_vertices; ++j)
+      if((required & (1 << j)) && !neighbors[j]) return false;
+    for(uint index = 0; index < min_neighbors.size(); ++index){
+      uint64_t selected = 0;
+      for(uint j = 0; j < profile_vertices; ++j)
+        if(!(index & (1 << j))) selected |= neighbors[j];
+      const int count = __builtin_popcountll(selected);
+      if(count < min_neighbors[index] || count > max_neighbors[index]) return false;
+    }
+    return true;
+  }
+};
+
+// add all graphs of the equivalence class of the target profile, agreeing on a fixed internal graph,
+// whose attachments to the profile vertices are given by 'codes' (of the attachment layout),
+// by recording the codes of those in 'matches'
+// adding an edge between an internal vertex x and a profile vertex j never decreases an entry S of the profile:
+// if j is in S nothing changes, otherwise x may join N(B - S), which costs 1 and saves at most 1 in the VC of
+// the rest, so the profile of some attachments bounds the profiles of all their supersets from below
+// the bound is evaluated without solving anything, using the VC numbers of all induced subgraphs of the
+// internal graph (computed once per internal graph and shared by all targets; above
+// ATTACHMENT_BOUND_MAX_VERTICES internal vertices, that table is too large and they're bounded by 0)
+class attachment_bound {
+  const uint internal_vertices;
+  const uint profile_vertices;
+  // max_entries[k] = target k + offset
+  vector<vector<int> > max_entries;
+  // residual_vc[X] = VC number of the internal graph minus the vertices in X (empty if there are too many vertices)
+  vector<byte> residual_vc;
+  // scratch space: selected[T] = internal neighbors of the profile vertices in T
+  // (so a bound can only be used by one thread at a time)
+  mutable vector<uint64_t> selected;
+public:
+  // bit j of internal_rows[i] is set iff ij is an edge of the internal graph
+  attachment_bound(const uint _internal_vertices,
+                   const uint _profile_vertices,
+                   const vector<uint64_t>& internal_rows):
+    internal_vertices(_internal_vertices), profile_vertices(_profile_vertices),
+    selected((size_t)1 << _profile_vertices)
+  {
+    if(internal_vertices > ATTACHMENT_BOUND_MAX_VERTICES) return;
+    // vc[Y] = VC number of the subgraph induced by Y: if v has a neighbor in Y, then either v
+    // or all of its neighbors in Y are in the VC (both alternatives leave subsets of Y, which we know already)
+    vector<byte> vc((size_t)1 << internal_vertices, 0);
+    for(uint64_t Y = 1; Y < vc.size(); ++Y){
+      for(uint64_t rest = Y; rest; rest &= rest - 1){
+        const uint v(__builtin_ctzll(rest));
+        const uint64_t N(internal_rows[v] & Y);
+        if(!N) continue;
+        const uint64_t without_v(Y & ~((uint64_t)1 << v));
+        vc[Y] = min(1 + vc[without_v], __builtin_popcountll(N) + vc[without_v & ~N]);
+        break;
+      }
+    }
+    residual_vc.resize(vc.size());
+    for(uint64_t X = 0; X < vc.size(); ++X) residual_vc[X] = vc[(vc.size() - 1) & ~X];
+  }
+
+  // also accept the attachments that may reach this target profile (+ the offset given by the VC number
+  // of the internal graph)
+  void add_target(const profile_t& target, const uint vc_num){
+    const int offset = (int)vc_num - target.back();
+    max_entries.push_back(vector<int>(target.size()));
+    for(uint index = 0; index < target.size(); ++index) max_entries.back()[index] = (int)target[index] + offset;
+  }
+
+  // false if no superset of the attachments in 'code' can have any of the target profiles (+ offset)
+  template<class Code>
+  bool operator()(const Code& code) const {
+    // bit i * profile_vertices + j of code stands for the edge between internal vertex i and profile vertex j
+    selected[0] = 0;
+    for(uint T = 1; T < selected.size(); ++T){
+      const uint j(__builtin_ctz(T));
+      uint64_t neighbors = 0;
+      for(uint i = 0; i < internal_vertices; ++i)
+        if(code.test(i * profile_vertices + j)) neighbors |= (uint64_t)1 << i;
+      selected[T] = selected[T & (T - 1)] | neighbors;
+    }
+    for(const vector<int>& max_entry : max_entries){
+      uint S = 0;
+      for(; S < selected.size(); ++S){
+        const uint64_t sel(selected[(selected.size() - 1) & ~S]);
+        if(__builtin_popcountll(sel) + (residual_vc.empty() ? 0 : residual_vc[sel]) > max_entry[S]) break;
+      }
+      if(S == selected.size()) return true;
+    }
+    return false;
+  }
+};
+
+template<class Code>
 void equiv_class_fixed_internal(const graph& g, 
                                 const profile_t& target,
                                 const uint profile_vertices,
-                                list<graph>& equiv_class,
-                                const uint vc_num){
+                                const vector<Code>& codes,
+                                vector<Code>& matches,
+                                const uint vc_num,
+                                rejection_statistics& stats,
+                                thread_pool* pool = NULL){
+  if(codes.empty()) return;
   const uint internal_vertices(g.vertices.size());
-  // forbit edges between A, B, C, D
-  AdjMatrix edges(internal_vertices, vector<bool>(profile_vertices)); // wastes space, but simplifies the program
-  for(uint i = 0; i < internal_vertices; ++i)
-    for(uint j = 0; j < profile_vertices; ++j)
-      edges[i][j] = false;
-
-  DEBUG1(cerr << "internal graph: "<<endl; g.print_edges(cerr););
-  do {
-    // get the graph based on 'edges'
-    graph gprime(g);
-    add_profile_to_internal(gprime, edges);
-    DEBUG5(cout << "added profile vertices, finished graph is: "<< gprime<< endl);
-  
-    print_if_equal(equiv_class, gprime, target, profile_vertices, vc_num);
-  } while(advance_to_next_bipartite_graph(edges));
-}
-
-
-bool push_back_if_not_isomorphic(list<graph>& created_graphs, graph& g){
-  DEBUG3(cout << "checking "<<g<<" against "<<created_graphs.size() << " saved graphs..."<<endl);
-  for(list<graph>::iterator i = created_graphs.begin(); i != created_graphs.end(); ++i)
-    if(isomorphic(g, *i)) return false;
-  DEBUG3(cout << "passed"<<endl);
-  // g is not isomorphic to anything in the list, so add it
-  created_graphs.push_back(g);
+  const vector<uint> border(consecutive_ids(internal_vertices, profile_vertices));
+  const edge_layout layout(edge_layout::attachments(internal_vertices, profile_vertices));
+
+  // the candidate graph, updated one edge at a time
+  graph gprime(g);
+  Code current(codes.front());
+  add_profile_to_internal(gprime, layout, current, profile_vertices);
+  profile_cache cache(target.size());
+  // check the entries that rejected the most candidates so far first
+  const vector<uint> lattice(cache.order);
+  stats.suggest_order(lattice, cache.order);
+  uint until_reorder = CHECK_ORDER_INTERVAL;
+  for(const Code& code : codes){
+    if(--until_reorder == 0){
+      stats.suggest_order(lattice, cache.order);
+      until_reorder = CHECK_ORDER_INTERVAL;
+    }
+    // toggle the edges in which the next candidate differs from the current one
+    // (few of them, since consecutive codes of the search differ in few bits)
+    for(Code diff = current ^ code; !diff.empty(); diff.clear_lowest()){
+      const uint flipped(diff.lowest());
+      toggle_edge(gprime, layout[flipped].first, layout[flipped].second);
+      cache.invalidate_border(flipped % profile_vertices);
+    }
+    current = code;
+    DEBUG5(cout << "current candidate graph is: "<< gprime<< endl);
+    record_if_equal(matches, code, gprime, target, border, vc_num, cache, pool, &stats);
+  }
+}
+
+// compute the profiles of the attachments 'codes' of the profile vertices to g
+// entry S of the profile of codes[c] goes to profiles[c * 2^profile_vertices + S]
+template<class Code>
+void profiles_fixed_internal(const graph& g,
+                             const uint profile_vertices,
+                             const vector<Code>& codes,
+                             vector<uint>& profiles){
+  const uint profile_size(1u << profile_vertices);
+  profiles.resize(codes.size() * profile_size);
+  if(codes.empty()) return;
+  const uint internal_vertices(g.vertices.size());
+  const vector<uint> border(consecutive_ids(internal_vertices, profile_vertices));
+  const edge_layout layout(edge_layout::attachments(internal_vertices, profile_vertices));
+
+  // the candidate graph, updated one edge at a time
+  graph gprime(g);
+  Code current(codes.front());
+  add_profile_to_internal(gprime, layout, current, profile_vertices);
+  profile_cache cache(profile_size);
+  for(size_t c = 0; c < codes.size(); ++c){
+    for(Code diff = current ^ codes[c]; !diff.empty(); diff.clear_lowest()){
+      const uint flipped(diff.lowest());
+      toggle_edge(gprime, layout[flipped].first, layout[flipped].second);
+      cache.invalidate_border(flipped % profile_vertices);
+    }
+    current = codes[c];
+    const profile_t& p(update_profile(gprime, border, cache));
+    copy(p.begin(), p.end(), profiles.begin() + c * profile_size);
+  }
+}
+
+
+// the image of the attachment code under the permutation sigma of the internal vertices
+// (bit i * profile_vertices + j moves to bit sigma[i] * profile_vertices + j)
+template<class Code>
+Code permute_attachments(const Code& code, const vector<uint>& sigma, const uint profile_vertices){
+  Code result;
+  for(uint i = 0; i < sigma.size(); ++i)
+    result.set_bits(sigma[i] * profile_vertices, code.bits(i * profile_vertices, profile_vertices));
+  return result;
+}
+
+// two candidates with the same internal graph are isomorphic (with the profile vertices fixed) iff an automorphism
+// of the internal graph maps the attachment code of one to the other, so the smallest code in the orbit of a code
+// under the automorphisms is a canonical form of its candidate
+template<class Code>
+bool is_canonical(const Code& code, const vector<vector<uint> >& automorphisms, const uint profile_vertices){
+  for(const vector<uint>& sigma : automorphisms)
+    if(permute_attachments(code, sigma, profile_vertices) < code) return false;
   return true;
 }
 
-void output_equivalence_class(const profile_t& target, const uint internal_vertices, const uint profile_vertices){
-  list<graph> equiv_class;
-  const uint last_profile_entry(target[pow(2, profile_vertices) - 1]);
+// the number of attachment codes that yield candidates isomorphic to the one of 'code'
+template<class Code>
+uint orbit_size(const Code& code, const vector<vector<uint> >& automorphisms, const uint profile_vertices){
+  uint stabilizer = 0;
+  for(const vector<uint>& sigma : automorphisms)
+    if(permute_attachments(code, sigma, profile_vertices) == code) ++stabilizer;
+  return automorphisms.size() / stabilizer;
+}
 
-  DEBUG3(cout << "generating all "<<internal_vertices<<"-vertex graphs of VC num "<<last_profile_entry<<endl);
-  // STEP 1. generate all internal graph whose vertex cover is at most the profile's last entry
-  // (when all profile vertices are in)
-  AdjMatrix internal_edges(internal_vertices, vector<bool>(internal_vertices)); // wastes space, but simplifies the program
+// a batch of candidates travelling through the stages of output_equivalence_class
+template<class Code>
+struct candidate_batch {
+  // position of the batch in the enumeration, so the output does not depend on the scheduling
+  uint64_t seq;
+  const graph* internal;
+  uint vc_num;
+  // the automorphisms of 'internal' (if we are looking for representatives only)
+  const vector<vector<uint> >* automorphisms;
+  // the attachments of the profile vertices to 'internal' to try
+  // (the filter drops those violating cheap necessary conditions)
+  vector<Code> codes;
+  // those of them that have a target profile
+  vector<Code> matches;
+  // the targets they match, if there are several (matches[i] matches matched_targets[i])
+  vector<uint> matched_targets;
+
+  candidate_batch(const uint64_t _seq, const graph* _internal, const uint _vc_num,
+                  const vector<vector<uint> >* _automorphisms):
+    seq(_seq), internal(_internal), vc_num(_vc_num), automorphisms(_automorphisms), codes(), matches(), matched_targets() {}
+};
+
+// the search for the equivalence classes is a pipeline of stages connected by bounded queues of batches:
+// 1. a generator thread enumerates internal graphs and cuts their attachments into batches,
+// 2. a filter thread drops the attachments violating cheap necessary conditions,
+// 3. the workers of the pool compute the profiles of the remaining candidates,
+// 4. this thread collects the batches and outputs them in order (the generator waits while it is
+//    PIPELINE_QUEUE_SIZE batches ahead of the oldest batch not output yet)
+// a single target is checked entry by entry, giving up on a candidate at the first mismatch, and its
+// equivalence class is output as it's found; for several targets, the full profile of each candidate is
+// looked up among the targets (normalized to end in 0) and the classes are output in the end, each
+// headed by the name of its target
+// 'names' are the file names of the targets, printed in the headers (they are empty in "graph" mode,
+// whose header has no name, and "batch" mode prints them even for a single target)
+// if 'kernels' is given, the profiles are computed by its packed kernels, otherwise on graphs
+// if 'representatives' is set, only one graph of each isomorphism class (fixing the profile vertices)
+// is output, preceded by the number of graphs in that class
+// only graphs satisfying the constraints are generated
+// if 'print_statistics' is set, the metrics of the queues and the rejection statistics of the profile checks
+// are written to cerr in the end
+template<class Code>
+void output_equivalence_classes(const vector<profile_t>& targets,
+                                const vector<string>& names,
+                                const uint internal_vertices,
+                                const uint profile_vertices,
+                                thread_pool& pool,
+                                const packed_kernels<Code>* kernels,
+                                const bool representatives,
+                                const enumeration_constraints& constraints,
+                                const bool print_statistics = false){
+  const bool single(targets.size() == 1);
+  // an internal graph is only interesting for the targets whose last entry is at least its VC number
+  uint last_profile_entry = 0;
+  for(const profile_t& target : targets) last_profile_entry = max(last_profile_entry, target.back());
+  const auto applicable_targets = [&targets](const uint vc_num){
+    vector<uint> result;
+    for(uint t = 0; t < targets.size(); ++t) if(targets[t].back() >= vc_num) result.push_back(t);
+    return result;
+  };
+  // the targets with each normalized profile
+  unordered_map<profile_t, vector<uint>, profile_hasher> target_index;
+  for(uint t = 0; t < targets.size(); ++t){
+    profile_t normalized(targets[t]);
+    for(uint& entry : normalized) entry -= targets[t].back();
+    target_index[normalized].push_back(t);
+  }
+
+  typedef candidate_batch<Code> batch_t;
+  bounded_queue<batch_t*> generated("generate->filter", PIPELINE_QUEUE_SIZE);
+  bounded_queue<batch_t*> filtered("filter->solve", PIPELINE_QUEUE_SIZE);
+  bounded_queue<batch_t*> solved("solve->aggregate", PIPELINE_QUEUE_SIZE);
+  // the batches that overtook their predecessors wait here, and the generator never gets further ahead
+  // of the oldest batch that is not output yet
+  reorder_buffer<batch_t*> in_order("aggregate", PIPELINE_QUEUE_SIZE);
+  atomic<uint64_t> rejected(0);
+  atomic<uint64_t> duplicates(0);
+  // which entries of the profile reject the candidates (if the profiles of a single target are computed on graphs)
+  rejection_statistics stats(targets.front().size());
+  // the internal graphs the batches refer to and their automorphisms
+  // (lists, so they don't move while we're adding more)
   list<graph> created_graphs;
+  list<vector<vector<uint> > > created_automorphisms;
 
-  for(uint i = 0; i < internal_vertices; ++i)
-    for(uint j = i; j < internal_vertices; ++j)
-      internal_edges[i][j] = false;  
-  do {
-    // get the graph based on 'internal_edges', no profile
-    graph g(get_graph(internal_edges, 0));
-    DEBUG5(cout << "created graph "<< g<< endl);
-    // compute its vertex cover s
-    solution_t s(run_branching_algo(g));
-    if(s.size() <= last_profile_entry){ 
-      graph gprime(get_graph(internal_edges, 0));
-      if(push_back_if_not_isomorphic(created_graphs, gprime))
-        equiv_class_fixed_internal(created_graphs.back(), target, profile_vertices, equiv_class, s.size());
-    }
-  } while(advance_to_next_graph(internal_edges, 0));
+  // STAGE 1. generate all internal graph whose vertex cover is at most the profiles' last entry
+  // (when all profile vertices are in) and all ways to attach the profile vertices to them
+  thread generator([&](){
+      DEBUG3(cout << "generating all "<<internal_vertices<<"-vertex graphs of VC num "<<last_profile_entry<<endl);
+      const edge_layout layout(internal_vertices, 0);
+      const edge_layout attachment_layout(edge_layout::attachments(internal_vertices, profile_vertices));
+      vector<bool> border(attachment_layout.num_vertices(), false);
+      for(uint j = 0; j < profile_vertices; ++j) border[internal_vertices + j] = true;
+      uint64_t seq = 0;
+      // attach the profile vertices in all possible ways to the internal graph created_graphs.back(),
+      // which has the given code and VC number
+      const auto attach = [&](const Code& code, const uint vc_num){
+        const auto new_batch = [&](){
+          in_order.reserve(seq);
+          return new batch_t(seq++, &created_graphs.back(), vc_num, &created_automorphisms.back());
+        };
+        // the attachments making the whole graph satisfy the constraints, found by a depth-first search
+        // over the attachment edges that gives up on a subtree as soon as a profile entry is too large
+        // for all targets (the internal vertices are numbered the same in both layouts)
+        vector<pair<uint, uint> > internal_edges;
+        vector<uint64_t> internal_rows(internal_vertices, 0);
+        for(uint bit = 0; bit < layout.size(); ++bit)
+          if(code.test(bit)){
+            const pair<uint, uint>& e(layout[bit]);
+            internal_edges.push_back(e);
+            internal_rows[e.first] |= (uint64_t)1 << e.second;
+            internal_rows[e.second] |= (uint64_t)1 << e.first;
+          }
+        attachment_bound extensible(internal_vertices, profile_vertices, internal_rows);
+        for(const uint t : applicable_targets(vc_num)) extensible.add_target(targets[t], vc_num);
+        batch_t* batch(new_batch());
+        constrained_enumerator<Code>(attachment_layout, constraints, border, internal_edges).for_each([&](const Code& attachment){
+            batch->codes.push_back(attachment);
+            if(batch->codes.size() == ATTACHMENT_CHUNK_SIZE){
+              generated.push(batch);
+              batch = new_batch();
+            }
+          }, extensible);
+        generated.push(batch);
+      };
+      // the attachments can still connect the internal graph or add edges to isolated vertices,
+      // so only the bound on the degree can be enforced on the internal graphs
+      if(internal_vertices <= CATALOGUE_MAX_VERTICES){
+        // the internal graphs up to isomorphism come from the catalogue, in the order of their codes
+        const graph_catalogue catalogue(internal_vertices);
+        vector<catalogue_entry> internal_graphs(catalogue.begin(), catalogue.end_of_vc(last_profile_entry));
+        sort(internal_graphs.begin(), internal_graphs.end(), [](const catalogue_entry& a, const catalogue_entry& b){
+            return a.code < b.code;
+          });
+        DEBUG1(cerr << internal_graphs.size()<<" of the "<<catalogue.size()<<" internal graphs have small enough VC num"<<endl);
+        for(const catalogue_entry& entry : internal_graphs){
+          vector<uint> degrees(internal_vertices, 0);
+          for(uint bit = 0; bit < layout.size(); ++bit)
+            if(entry.code & ((uint64_t)1 << bit)){
+              ++degrees[layout[bit].first];
+              ++degrees[layout[bit].second];
+            }
+          if(!degrees.empty() && *max_element(degrees.begin(), degrees.end()) > constraints.max_degree) continue;
+          created_graphs.push_back(get_graph(layout, Code(entry.code), 0));
+          DEBUG1(cerr << "internal graph: "<<endl; created_graphs.back().print_edges(cerr););
+          // the ids of the internal vertices are their positions in the vertex list, so the
+          // automorphisms permute the ids (if there is only the identity, we don't need to search for it)
+          vector<uint> identity(internal_vertices);
+          for(uint i = 0; i < internal_vertices; ++i) identity[i] = i;
+          created_automorphisms.push_back(!representatives ? vector<vector<uint> >() :
+                                          entry.automorphisms == 1 ? vector<vector<uint> >(1, identity) :
+                                          automorphisms(created_graphs.back()));
+          attach(Code(entry.code), entry.vc_num);
+        }
+      } else {
+        // there is no catalogue of that many vertices, so grow the internal graphs from the largest one
+        for(const grown_entry& entry : grow_catalogue(internal_vertices, constraints.max_degree, last_profile_entry)){
+          const Code code(layout.encode<Code>(entry.rows.data()));
+          created_graphs.push_back(get_graph(layout, code, 0));
+          DEBUG1(cerr << "internal graph: "<<endl; created_graphs.back().print_edges(cerr););
+          created_automorphisms.push_back(representatives ? automorphisms(created_graphs.back()) : vector<vector<uint> >());
+          attach(code, entry.vc_num);
+        }
+      }
+      generated.close();
+    });
 
-  // output the equivalence classes
+  // STAGE 2. filter the attachments
+  thread filter([&](){
+      batch_t* batch;
+      while(generated.pop(batch)){
+        vector<attachment_filter> filters;
+        for(const uint t : applicable_targets(batch->vc_num))
+          filters.push_back(attachment_filter(targets[t], internal_vertices, profile_vertices, batch->vc_num));
+        const auto passes = [&filters](const Code& code){
+          for(const attachment_filter& f : filters) if(f(code)) return true;
+          return false;
+        };
+        // keep the candidates passing the filters at the front of the batch
+        size_t kept = 0;
+        for(const Code& code : batch->codes)
+          if(!passes(code)) ++rejected;
+          // an isomorphic candidate with a smaller code has the same profile, so it speaks for this one
+          else if(representatives && !is_canonical(code, *batch->automorphisms, profile_vertices)) ++duplicates;
+          else batch->codes[kept++] = code;
+        batch->codes.resize(kept);
+        // pass on empty batches as well, the aggregator is waiting for them
+        filtered.push(batch);
+      }
+      filtered.close();
+    });
+
+  // STAGE 3. compute profiles, one solver per worker of the pool
+  atomic<uint> running_solvers(pool.size());
+  task_group solvers(pool);
+  for(uint i = 0; i < pool.size(); ++i)
+    solvers.run([&](){
+        batch_t* batch;
+        vector<uint> profiles;
+        while(filtered.pop(batch)){
+          if(single){
+            if(kernels)
+              kernels->equiv_class_fixed_internal(*batch->internal, targets.front(), batch->codes, batch->matches, batch->vc_num);
+            else
+              equiv_class_fixed_internal(*batch->internal, targets.front(), profile_vertices, batch->codes, batch->matches, batch->vc_num, stats, &pool);
+          } else {
+            if(kernels)
+              kernels->profiles_fixed_internal(*batch->internal, batch->codes, profiles);
+            else
+              profiles_fixed_internal(*batch->internal, profile_vertices, batch->codes, profiles);
+            // the last entry of each candidate's profile is the VC number of the internal graph
+            const uint profile_size(1u << profile_vertices);
+            profile_t normalized(profile_size);
+            for(size_t c = 0; c < batch->codes.size(); ++c){
+              for(uint index = 0; index < profile_size; ++index)
+                normalized[index] = profiles[c * profile_size + index] - batch->vc_num;
+              const auto found(target_index.find(normalized));
+              if(found == target_index.end()) continue;
+              for(const uint t : found->second)
+                if(targets[t].back() >= batch->vc_num){
+                  batch->matches.push_back(batch->codes[c]);
+                  batch->matched_targets.push_back(t);
+                }
+            }
+          }
+          solved.push(batch);
+        }
+        // the last solver to finish tells the aggregator
+        if(--running_solvers == 0) solved.close();
+      });
+
+  // STAGE 4. output the equivalence classes, holding back batches that overtook their predecessors in the reorder buffer
   cout << "EQUIVALENCE CLASSES:"<<endl;
-  cout << "================ "<< target << " ============================= "<<endl;
-  // go through the list of graphs
-  for(auto l = equiv_class.begin(); l != equiv_class.end(); ++l)
-    l->print_edges(cout);
+  if(single) cout << "================ "<< targets.front() << " ============================= "<< (names.empty() ? string() : names.front()) <<endl;
+  const edge_layout layout(edge_layout::attachments(internal_vertices, profile_vertices));
+  const auto print_candidate = [&](const graph& internal, const vector<vector<uint> >& automorphisms, const Code& code){
+    if(representatives) cout << orbit_size(code, automorphisms, profile_vertices) << "x ";
+    graph g(internal);
+    add_profile_to_internal(g, layout, code, profile_vertices);
+    g.print_edges(cout);
+  };
+  // the members of the class of each target, if there are several (the batches are deleted, the graphs stay)
+  struct class_member {
+    const graph* internal;
+    const vector<vector<uint> >* automorphisms;
+    Code code;
+  };
+  vector<vector<class_member> > members(targets.size());
+  batch_t* batch;
+  while(solved.pop(batch))
+    in_order.insert(batch->seq, batch, [&](batch_t* const done){
+        // go through the list of graphs
+        for(size_t i = 0; i < done->matches.size(); ++i)
+          if(single)
+            print_candidate(*done->internal, *done->automorphisms, done->matches[i]);
+          else
+            members[done->matched_targets[i]].push_back(class_member{done->internal, done->automorphisms, done->matches[i]});
+        delete done;
+      });
+  solvers.wait();
+  generator.join();
+  filter.join();
+  if(!single)
+    for(uint t = 0; t < targets.size(); ++t){
+      cout << "================ "<< targets[t] << " ============================= "<< names[t] <<endl;
+      for(const class_member& m : members[t]) print_candidate(*m.internal, *m.automorphisms, m.code);
+    }
+
+  if(print_statistics || DEBUGLEVEL > 0){
+    generated.print_metrics(cerr);
+    filtered.print_metrics(cerr);
+    solved.print_metrics(cerr);
+    in_order.print_metrics(cerr);
+  }
+  DEBUG1(cerr << "filtered out "<<rejected<<" candidates and "<<duplicates<<" isomorphic copies, solved "<<vc_counter<<endl);
+  DEBUG1(cerr << settled_entries<<" profile entries were settled by their neighbors in the lattice"<<endl);
+  // only the generic path checking the entries of a single target one by one collects statistics and adapts its order
+  if(print_statistics){
+    if(single && !kernels) stats.print(cerr);
+    else cerr << "no rejection statistics: they are only collected when checking a single target without the packed kernels (see --generic)"<<endl;
+  }
 }
 
-void output_all_non_isomorphic(const uint num_verts){
+template<class Code>
+void output_all_non_isomorphic(const uint num_verts, const enumeration_constraints& constraints){
   DEBUG3(cout << "generating all "<<num_verts<<"-vertex graphs"<<endl);
   // STEP 1. generate all internal graph whose vertex cover is at most the profile's last entry
   // (when all profile vertices are in)
-  AdjMatrix edges(num_verts, vector<bool>(num_verts)); // wastes space, but simplifies the program
+  const edge_layout layout(num_verts, 0);
+  // the classes with the bounded degree (and connected ones, if asked for) come from the catalogue or are grown
+  // from it; the isolated vertices are checked on each class (that does not depend on the labeling)
+  vector<Code> codes;
+  for(const grown_entry& entry : grow_catalogue(num_verts, constraints.max_degree, UINT_MAX, constraints.connected))
+    if(constraints.satisfied_by(entry.rows.data(), num_verts))
+      codes.push_back(layout.encode<Code>(entry.rows.data()));
+  // the catalogue has the smallest code of each class, so list the classes as we used to find them: by that code
+  sort(codes.begin(), codes.end());
   list<graph> created_graphs;
-
-  for(uint i = 0; i < num_verts; ++i)
-    for(uint j = i; j < num_verts; ++j)
-      edges[i][j] = false;  
-  do {
-    // get the graph based on 'internal_edges', no profile
-    graph g(get_graph(edges, 0));
-    // compute its vertex cover
-    push_back_if_not_isomorphic(created_graphs, g);
-  } while(advance_to_next_graph(edges, 0));
+  for(const Code& code : codes) created_graphs.push_back(get_graph(layout, code, 0));
  
   // output the equivalence classes
   cout << "non-isomorphic "<<num_verts<<"-vertex graphs:"<<endl;
@@ -384,8 +1230,99 @@ void output_all_non_isomorphic(const uint num_verts){
     l->print_edges(cout);
 }
 
+// the number of border vertices A, B, ... of g: the longest prefix of the profile names that are all in g
+uint count_border_vertices(graph& g){
+  uint result = 0;
+  while(g.find_vertex_by_name(profile_name(result)) != g.vertices.end()) ++result;
+  return result;
+}
+
+// fail if g has an edge between two of its first 'border_size' border vertices: a gadget has no such edges
+// (they would be lost when applying the rule), and the profile of a rule has to be that of its gadget
+void check_no_border_edges(graph& g, const uint border_size, const string& name){
+  for(uint i = 0; i < border_size; ++i){
+    const vertex_p v(g.find_vertex_by_name(profile_name(i)));
+    for(edge_p e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
+      for(uint j = i + 1; j < border_size; ++j)
+        if(e->head->name == profile_name(j))
+          FAIL(name<<" has an edge between the border vertices "<<profile_name(i)<<" and "<<profile_name(j)<<", which rules cannot have");
+  }
+}
+
+// read the rules from a file listing pairs of graph files: a pattern gadget and its replacement,
+// whose border vertices are named A, B, ... (border vertices missing in the replacement are isolated);
+// the offset of a rule is the difference of the profiles, and the replacement has to be smaller than the
+// pattern, so that applying rules terminates
+vector<reduction_rule> read_rules(const string& filename, thread_pool& pool){
+  ifstream rule_file(filename.c_str());
+  if(!rule_file) FAIL("cannot read "<<filename);
+  vector<reduction_rule> result;
+  string pattern_name, replacement_name;
+  while(rule_file >> pattern_name){
+    if(!(rule_file >> replacement_name)) FAIL("the rule for "<<pattern_name<<" in "<<filename<<" has no replacement");
+    graph pattern_graph, replacement_graph;
+    pattern_graph.read_from_file(pattern_name.c_str());
+    replacement_graph.read_from_file(replacement_name.c_str());
+    const uint border_size(count_border_vertices(pattern_graph));
+    if(border_size > MAX_PROFILE_VERTICES)
+      FAIL(pattern_name<<" has "<<border_size<<" border vertices, but at most "<<MAX_PROFILE_VERTICES<<" are supported");
+    // isolated vertices are never in a minimum VC (and reading an empty file gives one without a name),
+    // so drop them from the replacement (the border vertices among them are added back)
+    for(vertex_p v = replacement_graph.vertices.begin(); v != replacement_graph.vertices.end();){
+      const vertex_p next(std::next(v));
+      if(v->degree() == 0) replacement_graph.delete_vertex(v);
+      v = next;
+    }
+    for(uint i = 0; i < border_size; ++i)
+      if(replacement_graph.find_vertex_by_name(profile_name(i)) == replacement_graph.vertices.end())
+        replacement_graph.add_vertex_fast(profile_name(i));
+    check_no_border_edges(pattern_graph, border_size, pattern_name);
+    check_no_border_edges(replacement_graph, border_size, replacement_name);
+    const vector<uint> pattern_border(get_border_ids(pattern_graph, border_size));
+    const vector<uint> replacement_border(get_border_ids(replacement_graph, border_size));
+    const gadget pattern(pattern_graph, pattern_border), replacement(replacement_graph, replacement_border);
+    if(!pattern.connected())
+      FAIL(pattern_name<<" has to be connected and have an internal vertex");
+    if(replacement.num_internal() > pattern.num_internal() ||
+       (replacement.num_internal() == pattern.num_internal() && replacement.count_edges() >= pattern.count_edges()))
+      FAIL(replacement_name<<" is not smaller than "<<pattern_name);
+
+    const profile_t pattern_profile(get_profile(pattern_graph, pattern_border, &pool));
+    const profile_t replacement_profile(get_profile(replacement_graph, replacement_border, &pool));
+    if(!(pattern_profile == replacement_profile))
+      FAIL(replacement_name<<" cannot replace "<<pattern_name<<": their profiles "<<replacement_profile<<" and "<<pattern_profile<<" differ");
+    const int offset(get_profile_offset(replacement_profile, pattern_profile));
+    DEBUG1(cout << "rule: "<<pattern_name<<" -> "<<replacement_name<<" (border size "<<border_size<<", offset "<<offset<<")"<<endl);
+    result.push_back(reduction_rule(pattern, replacement, offset));
+  }
+  return result;
+}
+
+// write the edges of g in the input format (isolated vertices get lost, but they are never in a minimum VC)
+void write_edges(const graph& g, ostream& out){
+  for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v)
+    for(edge_pc e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
+      if(e->head->id > v->id) out << v->name << " " << e->head->name << endl;
+}
+
+// fail if the enumeration of 'what' would need more bits per code than we have, otherwise return num_edges
+uint check_layout_edges(const uint num_edges, const string& what){
+  if(num_edges > MAX_LAYOUT_EDGES)
+    FAIL(what<<" have "<<num_edges<<" potential edges, but at most "<<MAX_LAYOUT_EDGES<<" are supported (reduce -n or -p)");
+  return num_edges;
+}
+
+// run the statement, in which Code is the type of the codes with 'words' words (see code_words)
+#define WITH_CODE_TYPE(words, ...) \
+  switch(words){ \
+    case 1: { typedef edge_code<1> Code; __VA_ARGS__; break; } \
+    case 2: { typedef edge_code<2> Code; __VA_ARGS__; break; } \
+    default: { typedef edge_code<MAX_CODE_WORDS> Code; __VA_ARGS__; } \
+  }
+
 uint internal_vertices = 4;
 uint profile_vertices = 4;
+uint num_threads = max(thread::hardware_concurrency(), 1u);
 
 int main(int argc, char** argv){
   // parse arguments
@@ -394,14 +1331,98 @@ int main(int argc, char** argv){
   // first: parse options
   if(arguments.find("-n") != arguments.end()) internal_vertices = atoi(arguments["-n"][0].c_str());
   if(arguments.find("-p") != arguments.end()) profile_vertices = atoi(arguments["-p"][0].c_str());
+  if(arguments.find("-t") != arguments.end()) num_threads = max(atoi(arguments["-t"][0].c_str()), 1);
+  enumeration_constraints constraints;
+  if(arguments.find("-d") != arguments.end()) constraints.max_degree = max(atoi(arguments["-d"][0].c_str()), 0);
+  constraints.connected = (arguments.find("--connected") != arguments.end());
+  constraints.all_border_attached = (arguments.find("--all-border-attached") != arguments.end());
+  constraints.no_isolated = (arguments.find("--no-isolated") != arguments.end());
+  if(arguments.find("--cache") != arguments.end()) set_cache_directory(arguments["--cache"][0]);
+  if(profile_vertices > MAX_PROFILE_VERTICES) FAIL("at most "<<MAX_PROFILE_VERTICES<<" profile vertices are supported (every solver thread caches a profile with 2^"<<profile_vertices<<" entries)");
+  // the codes have to hold the internal graphs, the attachments of the profile vertices to them, and in "all" mode whole graphs
+  uint code_edges = check_layout_edges(num_edges(internal_vertices), "internal graphs");
+  if(arguments.find("enum") == arguments.end())
+    code_edges = max(code_edges, check_layout_edges(internal_vertices * profile_vertices, "attachments"));
+  if(arguments.find("all") != arguments.end()){
+    code_edges = check_layout_edges(num_edges(internal_vertices) + internal_vertices * profile_vertices, "graphs");
+    if(constraints.none() && code_edges > MAX_COUNTED_EDGES)
+      FAIL("graphs with "<<code_edges<<" potential edges are too many to go through all of them (at most "<<MAX_COUNTED_EDGES<<" without constraints like -d or --connected)");
+  }
+  const uint words(code_words(code_edges));
+  thread_pool pool(num_threads);
+  // choose the kernels specialized to our numbers of internal and profile vertices, if there are any
+  const narrow_packed_kernels* kernels = NULL;
+  if(arguments.find("--generic") == arguments.end() &&
+     internal_vertices >= 1 && internal_vertices <= PACKED_MAX_VERTICES && profile_vertices >= 1 && profile_vertices <= PACKED_MAX_PROFILE)
+    kernels = &packed_kernel_table[internal_vertices - 1][profile_vertices - 1];
   // then: parse actions
   if(arguments.find("graph") != arguments.end()){
     // read profile from graph and output equivalent graphs
     graph g;
     g.read_from_file(arguments["graph"][0].c_str());
-    profile_t target(get_profile(g, profile_vertices));
+    const vector<uint> border(get_border_ids(g, profile_vertices));
+    const bool representatives = (arguments.find("-u") != arguments.end());
+    const bool print_statistics = (arguments.find("--stats") != arguments.end());
+    // the results are cached by the graph up to isomorphism (fixing the border) and everything else the output depends on
+    // results are only used by the program that computed them (if we cannot tell which one that is, we don't use the cache)
+    // hashing the executable and canonizing g take a while, so we only build the key if we use the cache
+    bool use_cache = (arguments.find("--no-cache") == arguments.end());
+    string key;
+    if(use_cache){
+      const string fingerprint(program_fingerprint());
+      use_cache = !fingerprint.empty();
+      ostringstream key_stream;
+      if(use_cache)
+        key_stream << "program " << fingerprint << " n " << internal_vertices << " p " << profile_vertices << " u " << representatives
+                   << " d " << constraints.max_degree << " connected " << constraints.connected
+                   << " all-border-attached " << constraints.all_border_attached << " no-isolated " << constraints.no_isolated
+                   << " graph " << canonical_form(g, border);
+      key = key_stream.str();
+    }
+    const result_cache cache;
+    // the cached value is the profile in the first line, followed by the output
+    // (with --stats, we compute them anyway to get the statistics, and store them afterwards)
+    string cached;
+    if(use_cache && !print_statistics && cache.lookup(key, cached)){
+      const size_t end_of_profile = cached.find('\n');
+      DEBUG1(cout << "found profile: "<<cached.substr(0, end_of_profile)<<" in the result cache"<<endl);
+      cout << cached.substr(end_of_profile + 1) << flush;
+      return 0;
+    }
+    profile_t target(get_profile(g, border, &pool));
     DEBUG1(cout << "found profile: "<<target<<" now looking for equivalent profiles..."<<endl);
-    output_equivalence_class(target, internal_vertices, profile_vertices);
+    // record the output while writing it
+    ostringstream output;
+    tee_buffer tee(cout.rdbuf(), output.rdbuf());
+    streambuf* const cout_buffer = cout.rdbuf(&tee);
+    WITH_CODE_TYPE(words, output_equivalence_classes<Code>(vector<profile_t>(1, target), vector<string>(), internal_vertices, profile_vertices,
+                                                           pool, kernels_for<Code>(kernels), representatives, constraints, print_statistics));
+    cout.flush();
+    cout.rdbuf(cout_buffer);
+    if(use_cache){
+      ostringstream value;
+      value << target << '\n' << output.str();
+      cache.store(key, value.str());
+    }
+
+  } else if(arguments.find("batch") != arguments.end()){
+    // read the names of the target graphs and output the equivalence classes of all of them at once
+    ifstream list_file(arguments["batch"][0].c_str());
+    if(!list_file) FAIL("cannot read "<<arguments["batch"][0]);
+    vector<string> names;
+    vector<profile_t> targets;
+    string name;
+    while(list_file >> name){
+      graph g;
+      g.read_from_file(name.c_str());
+      targets.push_back(get_profile(g, get_border_ids(g, profile_vertices), &pool));
+      names.push_back(name);
+      DEBUG1(cout << "found profile of "<<name<<": "<<targets.back()<<endl);
+    }
+    if(targets.empty()) FAIL("no target graphs in "<<arguments["batch"][0]);
+    WITH_CODE_TYPE(words, output_equivalence_classes<Code>(targets, names, internal_vertices, profile_vertices,
+                                                           pool, kernels_for<Code>(kernels), arguments.find("-u") != arguments.end(), constraints,
+                                                           arguments.find("--stats") != arguments.end()));
 
   } else if(arguments.find("profile") != arguments.end()){
 // TODO: implement me
@@ -409,8 +1430,20 @@ int main(int argc, char** argv){
 //    output_equivalence_class(target_profile);
 
   } else if(arguments.find("all") != arguments.end()){
-    output_all_profiles(internal_vertices, profile_vertices);
+    WITH_CODE_TYPE(words, output_all_profiles<Code>(internal_vertices, profile_vertices, pool, kernels_for<Code>(kernels), constraints));
   } else if(arguments.find("enum") != arguments.end()){
-    output_all_non_isomorphic(internal_vertices);
+    WITH_CODE_TYPE(words, output_all_non_isomorphic<Code>(internal_vertices, constraints));
+  } else if(arguments.find("apply") != arguments.end()){
+    // reduce the input graph with the rules and write the result, whose VC number is smaller by the offset
+    const vector<string>& params(arguments["apply"]);
+    const vector<reduction_rule> rules(read_rules(params[0], pool));
+    graph g;
+    g.read_from_file(params[1].c_str());
+    const int offset(kernelize(g, rules));
+    ofstream kernel_file(params[2].c_str());
+    write_edges(g, kernel_file);
+    if(!kernel_file) FAIL("cannot write "<<params[2]);
+    cout << "offset: "<<offset<<endl;
+    DEBUG1(cout << "the kernel has "<<g.vertices.size()<<" vertices"<<endl);
   } else usage(argv[0], std::cerr);
 }
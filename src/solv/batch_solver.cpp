@@ -0,0 +1,119 @@
+#include "batch_solver.hpp"
+
+#include <vector>
+#include <immintrin.h>
+
+using namespace std;
+
+namespace vc{
+
+  vector<uint64_t> compute_row_masks(){
+    vector<uint64_t> result(256, 0);
+    for(uint x = 0; x < 256; ++x)
+      for(uint i = 0; i < 8; ++i)
+        if(x & (1 << i)) result[x] |= (uint64_t)0xff << (8 * i);
+    return result;
+  }
+  const vector<uint64_t> row_mask_table(compute_row_masks());
+  const uint64_t* const row_masks = row_mask_table.data();
+
+  // a set T of vertices is independent in the packed graph g iff g & independence_masks[T] == 0
+  // (the rows of the vertices in T restricted to the columns in T are empty)
+  // the vertex cover number of g is the number of vertices minus the size of a largest independent set
+  // (vertices that are not there are isolated and belong to every maximal independent set)
+  vector<uint64_t> compute_independence_masks(){
+    vector<uint64_t> result(256);
+    for(uint x = 0; x < 256; ++x)
+      result[x] = row_mask_table[x] & ((uint64_t)x * 0x0101010101010101ull);
+    return result;
+  }
+  const vector<uint64_t> independence_masks(compute_independence_masks());
+
+
+  // only the vertices 0, ..., N - 1 may have edges, so only subsets of them are interesting
+  template<uint N>
+  void solve_batch_scalar(const uint64_t* adjacency, const size_t count, uint8_t* vc_out){
+    for(size_t k = 0; k < count; ++k){
+      const uint64_t g = adjacency[k];
+      uint best = 0;
+      for(uint T = 0; T < (1u << N); ++T)
+        if(!(g & independence_masks[T])) best = max(best, (uint)__builtin_popcount(T));
+      vc_out[k] = N - best;
+    }
+  }
+
+  // 4 graphs per vector
+  template<uint N>
+  __attribute__((target("avx2")))
+  void solve_batch_avx2(const uint64_t* adjacency, const size_t count, uint8_t* vc_out){
+    const size_t vectorized = count & ~(size_t)3;
+    for(size_t k = 0; k < vectorized; k += 4){
+      const __m256i g = _mm256_loadu_si256((const __m256i*)(adjacency + k));
+      __m256i best = _mm256_setzero_si256();
+      for(uint T = 0; T < (1u << N); ++T){
+        const __m256i hit = _mm256_and_si256(g, _mm256_set1_epi64x(independence_masks[T]));
+        const __m256i independent = _mm256_cmpeq_epi64(hit, _mm256_setzero_si256());
+        // all lane values are tiny, so 32-bit maxima are as good as 64-bit ones
+        best = _mm256_max_epi32(best, _mm256_and_si256(independent, _mm256_set1_epi64x(__builtin_popcount(T))));
+      }
+      uint64_t lanes[4];
+      _mm256_storeu_si256((__m256i*)lanes, best);
+      for(uint i = 0; i < 4; ++i) vc_out[k + i] = N - lanes[i];
+    }
+    solve_batch_scalar<N>(adjacency + vectorized, count - vectorized, vc_out + vectorized);
+  }
+
+  // 8 graphs per vector
+  template<uint N>
+  __attribute__((target("avx512f")))
+  void solve_batch_avx512(const uint64_t* adjacency, const size_t count, uint8_t* vc_out){
+    const size_t vectorized = count & ~(size_t)7;
+    for(size_t k = 0; k < vectorized; k += 8){
+      const __m512i g = _mm512_loadu_si512((const void*)(adjacency + k));
+      __m512i best = _mm512_setzero_si512();
+      for(uint T = 0; T < (1u << N); ++T){
+        // lanes in which T is independent
+        const __mmask8 independent = _mm512_testn_epi64_mask(g, _mm512_set1_epi64(independence_masks[T]));
+        best = _mm512_mask_max_epu64(best, independent, best, _mm512_set1_epi64(__builtin_popcount(T)));
+      }
+      uint64_t lanes[8];
+      _mm512_storeu_si512((void*)lanes, best);
+      for(uint i = 0; i < 8; ++i) vc_out[k + i] = N - lanes[i];
+    }
+    solve_batch_scalar<N>(adjacency + vectorized, count - vectorized, vc_out + vectorized);
+  }
+
+  typedef void (*batch_solver_t)(const uint64_t*, const size_t, uint8_t*);
+
+  template<uint N>
+  batch_solver_t choose_batch_solver(){
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")) return solve_batch_avx512<N>;
+    if(__builtin_cpu_supports("avx2")) return solve_batch_avx2<N>;
+    return solve_batch_scalar<N>;
+  }
+
+  template<uint N>
+  void solve_batch(const uint64_t* adjacency, const size_t count, uint8_t* vc_out){
+    static const batch_solver_t solver(choose_batch_solver<N>());
+    solver(adjacency, count, vc_out);
+  }
+
+  void solve_batch(const uint64_t* adjacency, const size_t count, uint8_t* vc_out){
+    solve_batch<PACKED_MAX_VERTICES>(adjacency, count, vc_out);
+  }
+
+  void solve_batch_scalar(const uint64_t* adjacency, const size_t count, uint8_t* vc_out){
+    solve_batch_scalar<PACKED_MAX_VERTICES>(adjacency, count, vc_out);
+  }
+
+  template void solve_batch<1>(const uint64_t*, const size_t, uint8_t*);
+  template void solve_batch<2>(const uint64_t*, const size_t, uint8_t*);
+  template void solve_batch<3>(const uint64_t*, const size_t, uint8_t*);
+  template void solve_batch<4>(const uint64_t*, const size_t, uint8_t*);
+  template void solve_batch<5>(const uint64_t*, const size_t, uint8_t*);
+  template void solve_batch<6>(const uint64_t*, const size_t, uint8_t*);
+  template void solve_batch<7>(const uint64_t*, const size_t, uint8_t*);
+  template void solve_batch<8>(const uint64_t*, const size_t, uint8_t*);
+
+}
@@ -0,0 +1,36 @@
+#ifndef BATCH_SOLVER_HPP
+#define BATCH_SOLVER_HPP
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "../util/defs.hpp"
+
+// graphs solved by the batch solver have at most this many vertices
+#define PACKED_MAX_VERTICES 8
+
+namespace vc{
+
+  // a graph on (at most) 8 vertices packed into 64 bits: byte i is the adjacency row of vertex i,
+  // that is, bit 8 * i + j is set iff ij is an edge
+
+  // row_masks[x] has byte i set to 0xff iff bit i of x is set
+  extern const uint64_t* const row_masks;
+
+  // the subgraph of 'adjacency' induced by the vertices in 'keep' (the others become isolated)
+  inline uint64_t packed_induced(const uint64_t adjacency, const byte keep){
+    return adjacency & row_masks[keep] & ((uint64_t)keep * 0x0101010101010101ull);
+  }
+
+  // compute the vertex cover numbers of 'count' packed graphs at once, using the widest vector
+  // instructions the CPU supports (chosen at runtime)
+  void solve_batch(const uint64_t* adjacency, const size_t count, uint8_t* vc_out);
+  // the same for graphs in which only the vertices 0, 1, ..., N - 1 have edges (1 <= N <= 8)
+  template<uint N>
+  void solve_batch(const uint64_t* adjacency, const size_t count, uint8_t* vc_out);
+
+  // the same without vector instructions
+  void solve_batch_scalar(const uint64_t* adjacency, const size_t count, uint8_t* vc_out);
+}
+
+#endif
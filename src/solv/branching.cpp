@@ -1,12 +1,21 @@
 #include "../util/defs.hpp"
 #include "../util/graphs.hpp"
+#include "../util/thread_pool.hpp"
 #include "branching.hpp"
+#include "vc_table.hpp"
 
 #include <algorithm> // for sort
 #include <unordered_map>
 #include <unordered_set>
+#include <memory>
+#include <atomic>
 
 
+// graphs with less vertices are solved without bounding
+#define BNB_MIN_VERTICES 12
+// subtrees with less vertices are not worth handing to another thread
+#define PARALLEL_BRANCHING_MIN_VERTICES 24
+
 namespace vc{
 
 
@@ -24,17 +33,20 @@ namespace vc{
     return result;
   }
 
-  inline void deg0_reduct(graph& g, vertex_p& v, solution_t& s){
+  template<class Solution>
+  inline void deg0_reduct(graph& g, vertex_p& v, Solution& s){
     g.delete_vertex(v);
   }
 
-  inline void deg1_reduct(graph& g, vertex_p& v, solution_t& s){
+  template<class Solution>
+  inline void deg1_reduct(graph& g, vertex_p& v, Solution& s){
     const vertex_p neighbor(v->adj_list.front().head);
     select_vertex(g, neighbor, s);
   }
 
 
-  inline void deg2_reduct(graph& g, vertex_p& v, solution_t& s){
+  template<class Solution>
+  inline void deg2_reduct(graph& g, vertex_p& v, Solution& s){
     const vertex_p n1(v->adj_list.front().head);
     const vertex_p n2(v->adj_list.back().head);
     // that's all we needed from v
@@ -48,48 +60,102 @@ namespace vc{
       // 1. hang all neighbors of n1 to n2
       for(edge_p e = n1->adj_list.begin(); e != n1->adj_list.end(); ++e)
         g.add_edge_secure(n2, e->head);
-      // 2. delete n1
+      // 2. increase k (while we still know the name of n1)
+      add_folded_to_solution(s, n1, n2);
+      // 3. delete n1
       g.delete_vertex(n1);
-      // 3. increase k
-      s += ( n1->name + "/" + n2->name );
     }
 
   }
 
-  solution_t run_branching_algo(graph& g){
-    DEBUG4(cout << "running branching for graph with vertices: "<<g.vertices<<endl);
-    if(g.vertices.size() <= 1) return solution_t();
-    if(g.vertices.size() == 2){
-      if(g.vertices.front().adj_list.empty()) return solution_t();
-        else return solution_t(1, g.vertices.front().name);
+  // a vertex cover needs a distinct vertex for each edge of a matching and
+  // all but one vertex of each clique, so greedily compute both a maximal
+  // matching and a clique cover and take the better bound
+  uint lower_bound(graph& g){
+    unordered_map<uint, uint> clique_of(g.vertices.size());
+    vector<uint> clique_sizes;
+    vertexset matched;
+    uint matching_size = 0;
+    for(vertex_p v = g.vertices.begin(); v != g.vertices.end(); ++v){
+      // put v into the first clique it's completely adjacent to
+      vector<pair<uint, uint> > neighbors_in_clique;
+      for(edge_p e = v->adj_list.begin(); e != v->adj_list.end(); ++e){
+        const unordered_map<uint, uint>::const_iterator c(clique_of.find(e->head->id));
+        if(c == clique_of.end()) continue;
+        vector<pair<uint, uint> >::iterator i = neighbors_in_clique.begin();
+        while(i != neighbors_in_clique.end() && i->first != c->second) ++i;
+        if(i == neighbors_in_clique.end())
+          neighbors_in_clique.push_back(make_pair(c->second, 1));
+        else ++i->second;
+      }
+      uint clique = clique_sizes.size();
+      for(const pair<uint, uint>& c : neighbors_in_clique)
+        if(c.second == clique_sizes[c.first] && c.first < clique) clique = c.first;
+      if(clique == clique_sizes.size()) clique_sizes.push_back(0);
+      ++clique_sizes[clique];
+      clique_of[v->id] = clique;
+
+      // greedily match v to its first unmatched neighbor
+      if(matched.find(v) != matched.end()) continue;
+      for(edge_p e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
+        if(matched.find(e->head) == matched.end()){
+          matched.insert(v);
+          matched.insert(e->head);
+          ++matching_size;
+          break;
+        }
     }
-    vertex_p min_deg = find_min_deg_vertex(g);
-    DEBUG4(cout << "min degree vertex: "<<min_deg<<endl);
-    if(min_deg->degree() > 2){
-      // min-deg > 2
-      solution_t s1, s2;
+    return max(matching_size, (uint)(g.vertices.size() - clique_sizes.size()));
+  }
 
-      const vertex_p max_deg(find_max_deg_vertex(g));
-      unordered_map<uint, vertex_p> id_to_vertex;
-      graph gprime(g, &id_to_vertex);
-      const vertex_p max_deg_prime(id_to_vertex[max_deg->id]);
-
-      // either take him...
-      select_vertex(g, max_deg_prime, s1);
-      s1 += run_branching_algo(gprime);
-      DEBUG4(cout << " selecting "<<s1.front()<<" yielded size-"<<s1.size()<<" solution "<<s1<<endl);
-      // or take all his neighbors
-      for(edge_p e = max_deg->adj_list.begin(); e != max_deg->adj_list.end();){
-        vertex_p v = e->head;
-        ++e;
-        select_vertex(g, v, s2);
+  // get some (not necessarily optimal) vertex cover by taking neighbors of leaves and max-degree vertices
+  // NOTE: this destroys g
+  template<class Solution>
+  Solution greedy_cover(graph& g){
+    Solution s;
+    while(!g.vertices.empty()){
+      vertex_p min_deg = find_min_deg_vertex(g);
+      switch(min_deg->degree()){
+        case 0: deg0_reduct(g, min_deg, s); break;
+        case 1: deg1_reduct(g, min_deg, s); break;
+        default: select_vertex(g, find_max_deg_vertex(g), s);
       }
-      s2 += run_branching_algo(g);
-      // return the smaller solution
-      if(s1.size() < s2.size()) return s1; else return s2;
-    } else {
-      solution_t s;
-      // min-deg < 2
+    }
+    return s;
+  }
+
+  // if we only want the size of the solution, tiny graphs are solved by looking them up
+  // return whether g has been solved that way
+  template<class Solution>
+  inline bool solve_by_table(graph& g, Solution& s){ return false; }
+  inline bool solve_by_table(graph& g, solution_size_t& s){
+    if(g.vertices.size() > VC_TABLE_VERTICES) return false;
+    s.count += vc_table::get().lookup(g);
+    return true;
+  }
+
+  // branch and bound on g, where s is the partial solution that led to g
+  // solutions of size at least 'bound' are not interesting, so prune whenever
+  // s plus a lower bound for g reaches 'bound'
+  // solutions of size at most 'good_enough' are known to be optimal, so stop as soon as we find one
+  // return whether a solution of size less than bound has been found (it's then stored in s)
+  // NOTE: this destroys g
+  template<class Solution>
+  bool branch_and_bound(graph& g, Solution& s, const uint bound, const uint good_enough = 0){
+    DEBUG4(cout << "running branching for graph with vertices: "<<g.vertices<<endl);
+    // apply the degree-0, -1 and -2 reductions as long as possible
+    while(true){
+      if(solve_by_table(g, s)) return s.size() < bound;
+      if(bound != UINT_MAX && s.size() + lower_bound(g) >= bound) return false;
+      if(g.vertices.size() <= 1) return true;
+      if(g.vertices.size() == 2){
+        // the lower bound already accounted for the edge, if there is one
+        if(!g.vertices.front().adj_list.empty()) add_to_solution(s, g.vertices.begin());
+        return true;
+      }
+      vertex_p min_deg = find_min_deg_vertex(g);
+      DEBUG4(cout << "min degree vertex: "<<min_deg<<endl);
+      if(min_deg->degree() > 2) break;
       switch(min_deg->degree()){
         case 0: // degree-0, just delete it
           deg0_reduct(g, min_deg, s); break;
@@ -98,14 +164,142 @@ namespace vc{
         case 2: // degree-2,
           deg2_reduct(g, min_deg, s); break;
       }
-      s += run_branching_algo(g);
+    }
+    // min-deg > 2
+    const vertex_p max_deg(find_max_deg_vertex(g));
+    unordered_map<uint, vertex_p> id_to_vertex;
+    graph gprime(g, &id_to_vertex);
+
+    // either take him...
+    Solution s1(s);
+    select_vertex(gprime, id_to_vertex[max_deg->id], s1);
+    const bool found1 = branch_and_bound(gprime, s1, bound, good_enough);
+    DEBUG4(if(found1) cout << " selecting "<<max_deg<<" yielded size-"<<s1.size()<<" solution "<<s1<<endl);
+    if(found1 && s1.size() <= good_enough){
+      s.swap(s1);
+      return true;
+    }
+    // or take all his neighbors, which is only interesting if it beats the first branch
+    for(edge_p e = max_deg->adj_list.begin(); e != max_deg->adj_list.end();){
+      vertex_p v = e->head;
+      ++e;
+      select_vertex(g, v, s);
+    }
+    if(branch_and_bound(g, s, found1 ? s1.size() : bound, good_enough)) return true;
+    if(found1) s.swap(s1);
+    return found1;
+  }
+
+  template<class Solution>
+  Solution run_branching_algo(graph& g){
+    // on tiny graphs, bounding costs more than it saves
+    if(g.vertices.size() < BNB_MIN_VERTICES){
+      Solution s;
+      branch_and_bound(g, s, UINT_MAX);
       return s;
     }
+    // seed the incumbent with a greedy solution
+    graph gprime(g);
+    Solution incumbent(greedy_cover<Solution>(gprime));
+    DEBUG4(cout << "greedy solution: "<<incumbent<<endl);
+    // and try to beat it
+    Solution s;
+    if(branch_and_bound(g, s, incumbent.size())) return s; else return incumbent;
+  }
 
+  uint run_bounded_branching_algo(graph& g, const uint lower, const uint upper){
+    if(lower >= upper) return upper;
+    uint incumbent = upper;
+    // on tiny graphs, the greedy solution costs more than it saves
+    if(g.vertices.size() >= BNB_MIN_VERTICES){
+      graph gprime(g);
+      incumbent = min(incumbent, greedy_cover<solution_size_t>(gprime).size());
+      if(incumbent <= lower) return incumbent;
+    }
+    solution_size_t s;
+    return branch_and_bound(g, s, incumbent, lower) ? s.size() : incumbent;
   }
 
+  // lower 'best' to 'size' if that's an improvement, even if other threads are doing the same
+  inline void update_best(atomic<uint>& best, const uint size){
+    uint current = best;
+    while(size < current && !best.compare_exchange_weak(current, size));
+  }
 
+  // a node of the search tree: a graph and the size of the partial solution that led to it
+  typedef pair<shared_ptr<graph>, uint> search_node;
 
-}; // end namespace
+  // explore the search tree below 'root' using an explicit stack
+  // if the pool has idle threads, subtrees are handed to them as new tasks of 'tasks'
+  void explore_subtree(const search_node& root, atomic<uint>& best, thread_pool& pool, task_group& tasks){
+    vector<search_node> stack(1, root);
+    while(!stack.empty()){
+      const shared_ptr<graph> node(stack.back().first);
+      graph& g(*node);
+      solution_size_t s;
+      s.count = stack.back().second;
+      stack.pop_back();
 
+      // apply the degree-0, -1 and -2 reductions as long as possible
+      bool done = false;
+      while(!done){
+        if(solve_by_table(g, s)){
+          update_best(best, s.size());
+          break;
+        }
+        if(s.size() + lower_bound(g) >= best) break;
+        if(g.vertices.size() <= 2){
+          if(g.vertices.size() == 2 && !g.vertices.front().adj_list.empty()) ++s.count;
+          update_best(best, s.size());
+          break;
+        }
+        vertex_p min_deg = find_min_deg_vertex(g);
+        switch(min_deg->degree()){
+          case 0: deg0_reduct(g, min_deg, s); break;
+          case 1: deg1_reduct(g, min_deg, s); break;
+          case 2: deg2_reduct(g, min_deg, s); break;
+          default: done = true;
+        }
+      }
+      if(!done) continue;
+
+      // min-deg > 2, so branch on a max-degree vertex
+      const vertex_p max_deg(find_max_deg_vertex(g));
+      unordered_map<uint, vertex_p> id_to_vertex;
+      const shared_ptr<graph> gprime(new graph(g, &id_to_vertex));
+      solution_size_t s1(s);
+      select_vertex(*gprime, id_to_vertex[max_deg->id], s1);
+      // either take all his neighbors...
+      for(edge_p e = max_deg->adj_list.begin(); e != max_deg->adj_list.end();){
+        vertex_p v = e->head;
+        ++e;
+        select_vertex(g, v, s);
+      }
+      stack.push_back(search_node(node, s.size()));
+      // ...or take him, which we explore first (or give away if someone is idle)
+      const search_node child(gprime, s1.size());
+      if(pool.hungry() && gprime->vertices.size() >= PARALLEL_BRANCHING_MIN_VERTICES)
+        tasks.run([child, &best, &pool, &tasks](){ explore_subtree(child, best, pool, tasks); });
+      else stack.push_back(child);
+    }
+  }
+
+  uint run_parallel_branching_algo(graph& g, thread_pool& pool, const uint upper){
+    // seed the incumbent with a greedy solution (or the upper bound, if that's better)
+    graph gprime(g);
+    atomic<uint> best(min(upper, greedy_cover<solution_size_t>(gprime).size()));
+    DEBUG4(cout << "greedy solution size: "<<best<<endl);
+    // explore the search tree with the help of the pool
+    task_group tasks(pool);
+    explore_subtree(search_node(shared_ptr<graph>(new graph(g)), 0), best, pool, tasks);
+    tasks.wait();
+    return best;
+  }
+
+  template solution_t run_branching_algo<solution_t>(graph& g);
+  template solution_size_t run_branching_algo<solution_size_t>(graph& g);
+
+
+
+}; // end namespace
 
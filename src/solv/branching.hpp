@@ -2,14 +2,55 @@
 #define BRANCHING_HPP
 
 
+#include <stdint.h>
+
 namespace vc{
-  // run the complete branching recursively and return the number of operation it took
-  solution_t run_branching_algo(graph& g);
 
-  inline void select_vertex(graph& g, const vertex_p& v, solution_t& sol){
-    sol += v->name;
+  // if we are only interested in the size of the vertex cover, we don't need to know who's in it
+  struct solution_size_t {
+    uint count;
+
+    solution_size_t(): count(0) {}
+
+    inline uint size() const { return count; }
+    inline void swap(solution_size_t& s) { std::swap(count, s.count); }
+    inline solution_size_t& operator+=(const solution_size_t& s) { count += s.count; return *this; }
+  };
+
+  // put v into the solution sol
+  inline void add_to_solution(solution_t& sol, const vertex_p& v) { sol += v->name; }
+  inline void add_to_solution(solution_size_t& sol, const vertex_p& v) { ++sol.count; }
+
+  // the degree-2 vertex between n1 and n2 was folded into n2, costing one more vertex
+  inline void add_folded_to_solution(solution_t& sol, const vertex_p& n1, const vertex_p& n2) {
+    sol += ( n1->name + "/" + n2->name );
+  }
+  inline void add_folded_to_solution(solution_size_t& sol, const vertex_p& n1, const vertex_p& n2) { ++sol.count; }
+
+  // run branch and bound (seeded with a greedy solution) and return an optimal vertex cover
+  // NOTE: this destroys g
+  template<class Solution = solution_t>
+  Solution run_branching_algo(graph& g);
+
+  // return the size of an optimal vertex cover of g, which the caller knows to be between 'lower' and 'upper',
+  // so branches that cannot beat 'upper' are pruned and the search stops at the first solution of size 'lower'
+  // NOTE: this destroys g
+  uint run_bounded_branching_algo(graph& g, const uint lower, const uint upper);
+
+  class thread_pool;
+  // run branch and bound with an explicit stack, handing subtrees to idle threads of the pool
+  // all threads prune against the best solution size found by any of them
+  // return the size of an optimal vertex cover (or 'upper' if it is at least 'upper')
+  // NOTE: this destroys g
+  uint run_parallel_branching_algo(graph& g, thread_pool& pool, const uint upper = UINT_MAX);
+
+  template<class Solution>
+  inline void select_vertex(graph& g, const vertex_p& v, Solution& sol){
+    add_to_solution(sol, v);
     g.delete_vertex(v);
   }
 }
 
+inline ostream& operator<<(ostream& os, const vc::solution_size_t& s) {return os << s.count; }
+
 #endif
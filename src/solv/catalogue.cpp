@@ -0,0 +1,222 @@
+#include "catalogue.hpp"
+#include "branching.hpp"
+#include "../util/isomorphism.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <list>
+#include <map>
+#include <set>
+
+namespace vc{
+
+  // the cache file is a table file with this magic, whose parameter is the number of vertices
+  const char catalogue_magic[8] = { 'V', 'C', 'C', 'A', 'T', 'L', 'G', '1' };
+
+  graph_catalogue::graph_catalogue(const uint num_vertices):
+    layout(num_vertices, 0), entries(NULL), count(0), computed(), file()
+  {
+    assert(num_vertices <= CATALOGUE_MAX_VERTICES);
+    char name[64];
+    snprintf(name, sizeof(name), CATALOGUE_FILE, num_vertices);
+    const string filename(cache_path(name));
+    if(file.open(filename, catalogue_magic, num_vertices, sizeof(catalogue_entry))){
+      entries = (const catalogue_entry*)file.entries();
+      count = file.header().count;
+    } else {
+      DEBUG1(cerr << "computing the catalogue of all "<<num_vertices<<"-vertex graphs"<<endl);
+      compute();
+      entries = computed.data();
+      count = computed.size();
+      if(!write_table_file(filename, catalogue_magic, num_vertices, computed.data(), computed.size(), sizeof(catalogue_entry)))
+        DEBUG1(cerr << "could not save the graph catalogue to "<<filename<<endl);
+    }
+  }
+
+  // the graph with the given code, whose vertices have the ids 0, 1, ..., n - 1
+  graph graph_of(const edge_layout& layout, const uint64_t code){
+    graph g;
+    vector<vertex_p> vertices(layout.num_vertices());
+    for(uint id = 0; id < layout.num_vertices(); ++id) vertices[id] = g.add_vertex_fast(id, to_string(id));
+    for(uint bit = 0; bit < layout.size(); ++bit)
+      if(code & ((uint64_t)1 << bit)) g.add_edge_fast(vertices[layout[bit].first], vertices[layout[bit].second]);
+    return g;
+  }
+
+  void graph_catalogue::compute(){
+    const uint n(layout.num_vertices());
+    // edge_bit[u * n + v] = the bit of the edge uv
+    vector<uint> edge_bit(n * n, 0);
+    for(uint bit = 0; bit < layout.size(); ++bit){
+      edge_bit[layout[bit].first * n + layout[bit].second] = bit;
+      edge_bit[layout[bit].second * n + layout[bit].first] = bit;
+    }
+    // the codes come in increasing order, so the first code of each class we see is its smallest one;
+    // we mark the codes of all relabelings of it as seen, and the relabelings that give the code itself
+    // are its automorphisms
+    vector<bool> seen((uint64_t)1 << layout.size(), false);
+    vector<uint> relabel(n);
+    for(uint64_t code = 0; code < seen.size(); ++code){
+      if(seen[code]) continue;
+      uint32_t automorphisms = 0;
+      for(uint v = 0; v < n; ++v) relabel[v] = v;
+      do {
+        uint64_t image = 0;
+        for(uint64_t bits = code; bits; bits &= bits - 1){
+          const pair<uint, uint>& e(layout[__builtin_ctzll(bits)]);
+          image |= (uint64_t)1 << edge_bit[relabel[e.first] * n + relabel[e.second]];
+        }
+        seen[image] = true;
+        if(image == code) ++automorphisms;
+      } while(next_permutation(relabel.begin(), relabel.end()));
+
+      graph g(graph_of(layout, code));
+      const catalogue_entry entry = { code, automorphisms, (uint32_t)run_branching_algo<solution_size_t>(g).size() };
+      computed.push_back(entry);
+    }
+    sort(computed.begin(), computed.end(), [](const catalogue_entry& a, const catalogue_entry& b){
+        return a.vc_num < b.vc_num || (a.vc_num == b.vc_num && a.code < b.code);
+      });
+  }
+
+  // the graph with the given adjacency rows, whose vertices have the ids 0, 1, ..., n - 1
+  graph graph_of_rows(const vector<uint64_t>& rows){
+    graph g;
+    vector<vertex_p> vertices(rows.size());
+    for(uint id = 0; id < rows.size(); ++id) vertices[id] = g.add_vertex_fast(id, to_string(id));
+    for(uint u = 0; u < rows.size(); ++u)
+      for(uint64_t higher = rows[u] >> u >> 1; higher; higher &= higher - 1)
+        g.add_edge_fast(vertices[u], vertices[u + 1 + __builtin_ctzll(higher)]);
+    return g;
+  }
+
+  // the connected components of the graph with the given rows, each with its vertices renumbered 0, 1, ...
+  vector<vector<uint64_t> > components(const vector<uint64_t>& rows){
+    vector<vector<uint64_t> > result;
+    uint64_t seen = 0;
+    for(uint v = 0; v < rows.size(); ++v){
+      if((seen >> v) & 1) continue;
+      uint64_t component = 0;
+      for(uint64_t frontier = (uint64_t)1 << v; frontier; ){
+        component |= frontier;
+        uint64_t next = 0;
+        for(; frontier; frontier &= frontier - 1) next |= rows[__builtin_ctzll(frontier)];
+        frontier = next & ~component;
+      }
+      seen |= component;
+      // the vertices of the component keep their order
+      vector<uint> index(rows.size(), 0);
+      uint count = 0;
+      for(uint64_t rest = component; rest; rest &= rest - 1) index[__builtin_ctzll(rest)] = count++;
+      vector<uint64_t> renumbered;
+      for(uint64_t rest = component; rest; rest &= rest - 1){
+        uint64_t row = 0;
+        for(uint64_t neighbors = rows[__builtin_ctzll(rest)]; neighbors; neighbors &= neighbors - 1)
+          row |= (uint64_t)1 << index[__builtin_ctzll(neighbors)];
+        renumbered.push_back(row);
+      }
+      result.push_back(renumbered);
+    }
+    return result;
+  }
+
+  // the classes of one size, told apart by the canonical forms of their components or, if the search for
+  // one of them gives up, by isomorphism tests against the classes whose components have the same degrees
+  class grown_classes {
+    const uint max_vc;
+    set<vector<string> > forms;
+    // the graphs of the classes without complete canonical forms (in a list, so the pointers to them stay valid)
+    list<graph> graphs;
+    map<vector<vector<uint> >, vector<graph*> > by_degrees;
+  public:
+    vector<grown_entry> entries;
+
+    grown_classes(const uint _max_vc): max_vc(_max_vc), forms(), graphs(), by_degrees(), entries() {}
+
+    // add the graph with the given rows if its VC number is small enough and no earlier class contains it
+    void add(const vector<uint64_t>& rows){
+      // isomorphic graphs have the same multisets of component forms, and if the forms are complete,
+      // only isomorphic graphs have them
+      vector<string> form;
+      vector<vector<uint> > degrees;
+      bool complete = true;
+      for(const vector<uint64_t>& component : components(rows)){
+        bool component_complete;
+        form.push_back(canonical_form(graph_of_rows(component), vector<uint>(), &component_complete));
+        complete &= component_complete;
+        degrees.push_back(vector<uint>());
+        for(const uint64_t row : component) degrees.back().push_back(__builtin_popcountll(row));
+        sort(degrees.back().begin(), degrees.back().end());
+      }
+      sort(form.begin(), form.end());
+      sort(degrees.begin(), degrees.end());
+      graph g(graph_of_rows(rows));
+      if(complete){
+        if(!forms.insert(form).second) return;
+      } else {
+        vector<graph*>& same_degrees(by_degrees[degrees]);
+        for(graph* h : same_degrees)
+          if(isomorphic(g, *h)) return;
+        graphs.push_back(g);
+        same_degrees.push_back(&graphs.back());
+      }
+      // the other graphs of the class have the same VC number, so the class is remembered either way
+      const uint vc_num = run_branching_algo<solution_size_t>(g).size();
+      if(vc_num > max_vc) return;
+      const grown_entry entry = { rows, vc_num };
+      entries.push_back(entry);
+    }
+  };
+
+  // add the graphs made of 'rows' and a new vertex adjacent to 'neighbors' and to some of the candidates
+  // from 'first' on, having at most 'room' more neighbors (and at least one neighbor if 'connected')
+  void add_neighborhoods(grown_classes& classes, const vector<uint64_t>& rows, const vector<uint>& candidates,
+                         const uint first, const uint room, uint64_t neighbors, const bool connected){
+    if(neighbors || !connected || rows.empty()){
+      vector<uint64_t> extended(rows);
+      extended.push_back(neighbors);
+      for(uint64_t rest = neighbors; rest; rest &= rest - 1)
+        extended[__builtin_ctzll(rest)] |= (uint64_t)1 << rows.size();
+      classes.add(extended);
+    }
+    if(!room) return;
+    for(uint i = first; i < candidates.size(); ++i)
+      add_neighborhoods(classes, rows, candidates, i + 1, room - 1, neighbors | ((uint64_t)1 << candidates[i]), connected);
+  }
+
+  vector<grown_entry> grow_catalogue(const uint num_vertices, const uint max_degree, const uint max_vc, const bool connected){
+    assert(num_vertices <= 64);
+    const uint start = min(num_vertices, (uint)CATALOGUE_MAX_VERTICES);
+    enumeration_constraints hereditary;
+    hereditary.max_degree = max_degree;
+    hereditary.connected = connected;
+    vector<grown_entry> result;
+    {
+      const graph_catalogue catalogue(start);
+      const edge_layout layout(start, 0);
+      for(const catalogue_entry* entry = catalogue.begin(); entry != catalogue.end_of_vc(max_vc); ++entry){
+        grown_entry grown = { vector<uint64_t>(start), entry->vc_num };
+        layout.decode(edge_code<1>(entry->code), grown.rows.data());
+        if(hereditary.satisfied_by(grown.rows.data(), start)) result.push_back(grown);
+      }
+    }
+    for(uint n = start; n < num_vertices; ++n){
+      DEBUG1(cerr << "growing "<<result.size()<<" classes of "<<n<<"-vertex graphs by a vertex"<<endl);
+      grown_classes classes(max_vc);
+      for(const grown_entry& entry : result){
+        // the new vertex can only be adjacent to vertices with room for another neighbor
+        vector<uint> candidates;
+        for(uint v = 0; v < n; ++v)
+          if((uint)__builtin_popcountll(entry.rows[v]) < max_degree) candidates.push_back(v);
+        add_neighborhoods(classes, entry.rows, candidates, 0, min(max_degree, n), 0, connected);
+      }
+      result.swap(classes.entries);
+    }
+    return result;
+  }
+
+  const catalogue_entry* graph_catalogue::end_of_vc(const uint max_vc) const{
+    return upper_bound(begin(), end(), max_vc, [](const uint vc_num, const catalogue_entry& entry){ return vc_num < entry.vc_num; });
+  }
+
+}
@@ -0,0 +1,76 @@
+#ifndef CATALOGUE_HPP
+#define CATALOGUE_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "../util/defs.hpp"
+#include "../util/graphs.hpp"
+#include "../util/enumerators.hpp"
+#include "../util/mapped_file.hpp"
+
+// the catalogue of the graphs on n vertices is cached in this file of the cache directory (%u being replaced by n)
+#define CATALOGUE_FILE "catalogue_%u.bin"
+// computing the catalogue takes a bit for each of the 2^(n(n-1)/2) graphs on n vertices (32MB for 8 vertices)
+#define CATALOGUE_MAX_VERTICES 8
+
+using namespace std;
+
+namespace vc{
+
+  // an isomorphism class of graphs
+  struct catalogue_entry {
+    // the smallest code of a graph of the class in edge_layout(n, 0)
+    uint64_t code;
+    // the number of automorphisms of the graphs of the class
+    uint32_t automorphisms;
+    uint32_t vc_num;
+  };
+
+  // all graphs on n vertices up to isomorphism, sorted by their vertex cover numbers (and then by code),
+  // so the graphs up to some VC number are a prefix of the catalogue
+  class graph_catalogue {
+    const edge_layout layout;
+    // the entries, either memory mapped from the cache file or computed into 'computed'
+    const catalogue_entry* entries;
+    size_t count;
+    vector<catalogue_entry> computed;
+    mapped_file file;
+
+    // fill 'computed' by going through all codes in increasing order
+    void compute();
+
+    graph_catalogue(const graph_catalogue&);
+  public:
+    // load the catalogue of the graphs on 'num_vertices' vertices from its cache file (or compute and save it)
+    graph_catalogue(const uint num_vertices);
+
+    inline size_t size() const { return count; }
+    // whether the entries were loaded from the cache file (rather than computed)
+    inline bool from_file() const { return computed.empty(); }
+    inline const catalogue_entry* begin() const { return entries; }
+    inline const catalogue_entry* end() const { return entries + count; }
+    // the end of the graphs whose VC number is at most 'max_vc'
+    const catalogue_entry* end_of_vc(const uint max_vc) const;
+  };
+
+  // an isomorphism class of graphs on any number of vertices (at most 64), given by the adjacency rows
+  // of one of its graphs: bit j of rows[i] is set iff ij is an edge
+  struct grown_entry {
+    vector<uint64_t> rows;
+    uint vc_num;
+  };
+
+  // all graphs on 'num_vertices' vertices up to isomorphism whose maximum degree is at most 'max_degree'
+  // and whose VC number is at most 'max_vc', grown from the largest catalogue one vertex at a time:
+  // removing the last vertex of such a graph leaves such a graph, so giving the new vertex all possible
+  // neighborhoods in each class of one size reaches every class of the next size
+  // if 'connected', only the connected graphs are listed (and grown: each of them has a vertex whose removal
+  // leaves it connected, a leaf of a spanning tree)
+  // (the work grows with the number of classes and neighborhoods, so this is only feasible with strong bounds)
+  vector<grown_entry> grow_catalogue(const uint num_vertices, const uint max_degree, const uint max_vc, const bool connected = false);
+
+}
+
+#endif
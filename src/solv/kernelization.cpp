@@ -0,0 +1,179 @@
+#include "kernelization.hpp"
+
+#include <algorithm>
+#include <deque>
+
+namespace vc{
+
+  gadget::gadget(const graph& g, const vector<uint>& border):
+    border_size(border.size()), neighbors(g.vertices.size())
+  {
+    // number the border vertices by their position in the border and the others in the order of the vertex list
+    unordered_map<uint, uint> index;
+    for(uint i = 0; i < border.size(); ++i) index[border[i]] = i;
+    uint next = border.size();
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v)
+      if(index.find(v->id) == index.end()) index[v->id] = next++;
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v)
+      for(edge_pc e = v->adj_list.begin(); e != v->adj_list.end(); ++e){
+        const uint x = index[v->id], y = index[e->head->id];
+        if(!is_border(x) || !is_border(y)) neighbors[x].push_back(y);
+      }
+  }
+
+  uint gadget::count_edges() const{
+    uint result = 0;
+    for(const vector<uint>& n : neighbors) result += n.size();
+    return result / 2;
+  }
+
+  bool gadget::connected() const{
+    if(num_internal() == 0) return false;
+    vector<bool> seen(num_vertices(), false);
+    vector<uint> stack(1, border_size);
+    seen[border_size] = true;
+    uint count = 1;
+    while(!stack.empty()){
+      const uint x = stack.back();
+      stack.pop_back();
+      for(const uint y : neighbors[x])
+        if(!seen[y]){
+          seen[y] = true;
+          ++count;
+          stack.push_back(y);
+        }
+    }
+    return count == num_vertices();
+  }
+
+  reduction_rule::reduction_rule(const gadget& _pattern, const gadget& _replacement, const int _offset):
+    pattern(_pattern), replacement(_replacement), offset(_offset), order(), parent(pattern.num_vertices(), UINT_MAX)
+  {
+    assert(pattern.connected());
+    uint anchor = pattern.border_size;
+    for(uint x = pattern.border_size; x < pattern.num_vertices(); ++x)
+      if(pattern.neighbors[x].size() > pattern.neighbors[anchor].size()) anchor = x;
+    // breadth-first search from the anchor
+    vector<bool> seen(pattern.num_vertices(), false);
+    order.push_back(anchor);
+    seen[anchor] = true;
+    for(uint i = 0; i < order.size(); ++i)
+      for(const uint y : pattern.neighbors[order[i]])
+        if(!seen[y]){
+          seen[y] = true;
+          parent[y] = order[i];
+          order.push_back(y);
+        }
+  }
+
+  // map the vertices order[depth], order[depth + 1], ... of the pattern of r to vertices of g, extending 'image'
+  // (mapped[x] tells whether x is mapped already, and 'used' holds the images)
+  bool match(const reduction_rule& r, const uint depth, vector<vertex_p>& image, vector<bool>& mapped, vertexset& used){
+    if(depth == r.order.size()) return true;
+    const gadget& pattern(r.pattern);
+    const uint x = r.order[depth];
+    const vertex_p& p(image[r.parent[x]]);
+    for(edge_p e = p->adj_list.begin(); e != p->adj_list.end(); ++e){
+      const vertex_p w(e->head);
+      if(used.count(w)) continue;
+      // internal vertices have no neighbors outside the gadget, border vertices may have more
+      if(pattern.is_border(x) ? w->degree() < pattern.neighbors[x].size() : w->degree() != pattern.neighbors[x].size()) continue;
+      // the edges to the vertices that are mapped already have to be there
+      bool consistent = true;
+      for(uint i = 0; consistent && i < pattern.neighbors[x].size(); ++i){
+        const uint y = pattern.neighbors[x][i];
+        if(mapped[y]) consistent = adjacent(w, image[y]);
+      }
+      if(!consistent) continue;
+      image[x] = w;
+      mapped[x] = true;
+      used.insert(w);
+      if(match(r, depth + 1, image, mapped, used)) return true;
+      mapped[x] = false;
+      used.erase(w);
+    }
+    return false;
+  }
+
+  // the vertices of g within distance 'radius' of the vertices in 'start'
+  vector<vertex_p> neighborhood(const vector<vertex_p>& start, const uint radius){
+    vertexset seen(start.begin(), start.end());
+    vector<vertex_p> result(start);
+    uint level_begin = 0;
+    for(uint distance = 0; distance < radius && level_begin < result.size(); ++distance){
+      const uint level_end = result.size();
+      for(uint i = level_begin; i < level_end; ++i)
+        for(edge_p e = result[i]->adj_list.begin(); e != result[i]->adj_list.end(); ++e)
+          if(seen.insert(e->head).second) result.push_back(e->head);
+      level_begin = level_end;
+    }
+    return result;
+  }
+
+  int kernelize(graph& g, const vector<reduction_rule>& rules){
+    // a new occurrence contains one of the vertices whose neighborhood changed, and its anchor is at most
+    // 'radius' away from it, so only the vertices around a replacement have to be looked at again
+    uint radius = 0;
+    for(const reduction_rule& r : rules) radius = max(radius, r.pattern.num_vertices());
+    // names of the vertices we add
+    unordered_set<string> names;
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v) names.insert(v->name);
+    uint next_name = 0;
+
+    // the ids of the vertices that may be the anchor of an occurrence
+    deque<uint> candidates;
+    vector<bool> queued(g.current_id + 1, false);
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v){
+      candidates.push_back(v->id);
+      queued[v->id] = true;
+    }
+
+    int result = 0;
+    uint replacements = 0;
+    while(!candidates.empty()){
+      const uint id = candidates.front();
+      candidates.pop_front();
+      queued[id] = false;
+      const vertex_p v(g.find_vertex_by_id(id));
+      if(v == g.vertices.end()) continue;
+      for(const reduction_rule& r : rules){
+        const uint anchor = r.order.front();
+        if(v->degree() != r.pattern.neighbors[anchor].size()) continue;
+        vector<vertex_p> image(r.pattern.num_vertices());
+        vector<bool> mapped(r.pattern.num_vertices(), false);
+        vertexset used;
+        image[anchor] = v;
+        mapped[anchor] = true;
+        used.insert(v);
+        if(!match(r, 1, image, mapped, used)) continue;
+
+        // replace the internal vertices of the occurrence by those of the replacement
+        DEBUG2(cerr << "replacing an occurrence at "<<v->name<<" (offset "<<r.offset<<")"<<endl);
+        for(uint x = r.pattern.border_size; x < r.pattern.num_vertices(); ++x) g.delete_vertex(image[x]);
+        vector<vertex_p> changed(image.begin(), image.begin() + r.pattern.border_size);
+        for(uint x = r.replacement.border_size; x < r.replacement.num_vertices(); ++x){
+          string name;
+          do name = "r" + to_string(next_name++); while(!names.insert(name).second);
+          changed.push_back(g.add_vertex_fast(name));
+        }
+        // changed[x] is the vertex of g corresponding to vertex x of the replacement
+        for(uint x = 0; x < r.replacement.num_vertices(); ++x)
+          for(const uint y : r.replacement.neighbors[x])
+            if(x < y) g.add_edge_fast(changed[x], changed[y]);
+        result += r.offset;
+        ++replacements;
+
+        if(queued.size() <= g.current_id) queued.resize(g.current_id + 1, false);
+        for(const vertex_p& w : neighborhood(changed, radius))
+          if(!queued[w->id]){
+            queued[w->id] = true;
+            candidates.push_back(w->id);
+          }
+        break;
+      }
+    }
+    DEBUG1(cerr << "applied "<<replacements<<" replacements"<<endl);
+    return result;
+  }
+
+}
@@ -0,0 +1,54 @@
+#ifndef KERNELIZATION_HPP
+#define KERNELIZATION_HPP
+
+#include <vector>
+
+#include "../util/defs.hpp"
+#include "../util/graphs.hpp"
+
+using namespace std;
+
+namespace vc{
+
+  // a gadget: the vertices 0, 1, ..., border_size - 1 are its border (in the order of the border),
+  // the others are its internal vertices; there are no edges between border vertices (rules with
+  // such edges are rejected when they are read, since applying them would lose these edges)
+  struct gadget {
+    uint border_size;
+    // neighbors[x] = neighbors of vertex x
+    vector<vector<uint> > neighbors;
+
+    // the gadget of g with the border vertices with the given ids
+    gadget(const graph& g, const vector<uint>& border);
+
+    inline uint num_vertices() const { return neighbors.size(); }
+    inline uint num_internal() const { return neighbors.size() - border_size; }
+    inline bool is_border(const uint x) const { return x < border_size; }
+    uint count_edges() const;
+    // whether all vertices can be reached from the internal vertex 'border_size' (if there is one)
+    bool connected() const;
+  };
+
+  // a gadget, the gadget replacing it and the amount by which the replacement decreases the VC number
+  // (the profiles of pattern and replacement differ exactly by the offset)
+  struct reduction_rule {
+    gadget pattern;
+    gadget replacement;
+    int offset;
+    // the order in which the vertices of the pattern are matched: the first one is the internal vertex of
+    // largest degree, and each of the others has a neighbor earlier in the order, which is its parent
+    vector<uint> order;
+    vector<uint> parent;
+
+    // pattern has to be connected and have an internal vertex
+    reduction_rule(const gadget& _pattern, const gadget& _replacement, const int _offset);
+  };
+
+  // replace occurrences of the patterns of the rules in g as long as there are any, and return the sum of the offsets
+  // an occurrence maps the pattern injectively into g such that each edge of the pattern is an edge of g and the
+  // internal vertices have no other neighbors in g (so the border separates them from the rest of g)
+  int kernelize(graph& g, const vector<reduction_rule>& rules);
+
+}
+
+#endif
@@ -0,0 +1,67 @@
+#include "vc_table.hpp"
+
+#include <cstdio>
+
+namespace vc{
+
+  // the cache file is a table file with this magic, whose parameter is the number of vertices
+  const char vc_table_magic[8] = { 'V', 'C', 'T', 'A', 'B', 'L', 'E', '1' };
+
+  vc_table::vc_table(): layout(VC_TABLE_VERTICES, 0), entries(NULL), computed(), file() {
+    for(uint bit = 0; bit < layout.size(); ++bit){
+      edge_bit[layout[bit].first][layout[bit].second] = bit;
+      edge_bit[layout[bit].second][layout[bit].first] = bit;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), VC_TABLE_FILE, (uint)VC_TABLE_VERTICES);
+    const string filename(cache_path(name));
+    if(file.open(filename, vc_table_magic, VC_TABLE_VERTICES, sizeof(byte)) && file.header().count == size())
+      entries = (const byte*)file.entries();
+    else {
+      DEBUG1(cerr << "computing vertex cover numbers of all "<<VC_TABLE_VERTICES<<"-vertex graphs"<<endl);
+      compute();
+      entries = computed.data();
+      if(!write_table_file(filename, vc_table_magic, VC_TABLE_VERTICES, computed.data(), computed.size(), sizeof(byte)))
+        DEBUG1(cerr << "could not save the vertex cover table to "<<filename<<endl);
+    }
+  }
+
+  void vc_table::compute(){
+    // incident[v] = bits of all edges at v
+    uint64_t incident[VC_TABLE_VERTICES] = {};
+    for(uint bit = 0; bit < layout.size(); ++bit){
+      incident[layout[bit].first] |= (uint64_t)1 << bit;
+      incident[layout[bit].second] |= (uint64_t)1 << bit;
+    }
+    computed.resize(size());
+    computed[0] = 0;
+    // one of the ends of any edge uv is in the VC, and removing the edges of u (or v)
+    // clears the bit of uv, so both alternatives have smaller codes and are known already
+    for(uint64_t code = 1; code < size(); ++code){
+      const pair<uint, uint>& uv(layout[__builtin_ctzll(code)]);
+      computed[code] = 1 + min(computed[code & ~incident[uv.first]], computed[code & ~incident[uv.second]]);
+    }
+  }
+
+  uint vc_table::lookup(const graph& g) const{
+    assert(g.vertices.size() <= VC_TABLE_VERTICES);
+    // number the vertices in the order of the vertex list and translate the edges to their bits
+    const vertex* local[VC_TABLE_VERTICES];
+    uint64_t code = 0;
+    uint i = 0;
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v, ++i){
+      local[i] = &(*v);
+      for(edge_pc e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
+        for(uint j = 0; j < i; ++j)
+          if(local[j] == &(*e->head)) code |= (uint64_t)1 << edge_bit[i][j];
+    }
+    return entries[code];
+  }
+
+  const vc_table& vc_table::get(){
+    static const vc_table table;
+    return table;
+  }
+
+}
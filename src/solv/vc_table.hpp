@@ -0,0 +1,60 @@
+#ifndef VC_TABLE_HPP
+#define VC_TABLE_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "../util/defs.hpp"
+#include "../util/graphs.hpp"
+#include "../util/enumerators.hpp"
+#include "../util/mapped_file.hpp"
+
+// graphs with at most this many vertices are solved by looking up their vertex cover number
+// (the table has 2^(n(n-1)/2) one-byte entries: 2MB for 7 vertices, 256MB for 8 vertices)
+#ifndef VC_TABLE_VERTICES
+#define VC_TABLE_VERTICES 7
+#endif
+
+// the table is cached in this file of the cache directory (%u being replaced by VC_TABLE_VERTICES),
+// after a header identifying it
+#define VC_TABLE_FILE "vc_table_%u.bin"
+
+using namespace std;
+
+namespace vc{
+
+  // vertex cover numbers of all labelled graphs on VC_TABLE_VERTICES vertices, indexed by their
+  // code in edge_layout(VC_TABLE_VERTICES, 0); graphs with less vertices are padded with isolated ones
+  class vc_table {
+    const edge_layout layout;
+    // bit of the code corresponding to the edge between vertices i and j
+    byte edge_bit[VC_TABLE_VERTICES][VC_TABLE_VERTICES];
+    // the entries, either memory mapped from the cache file or computed into 'computed'
+    const byte* entries;
+    vector<byte> computed;
+    mapped_file file;
+
+    // fill 'computed' by dynamic programming in the order of the codes
+    void compute();
+
+    vc_table(const vc_table&);
+  public:
+    // load the table from its cache file (or compute and save it); the solver uses the one of get()
+    vc_table();
+
+    inline size_t size() const { return (size_t)1 << layout.size(); }
+    // whether the entries were loaded from the cache file (rather than computed)
+    inline bool from_file() const { return computed.empty(); }
+    inline uint operator[](const uint64_t code) const { return entries[code]; }
+
+    // the vertex cover number of g, which has to have at most VC_TABLE_VERTICES vertices
+    uint lookup(const graph& g) const;
+
+    // the table, loaded (or computed) on first use
+    static const vc_table& get();
+  };
+
+}
+
+#endif
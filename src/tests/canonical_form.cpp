@@ -0,0 +1,56 @@
+#include "../util/graphs.hpp"
+#include "../util/isomorphism.hpp"
+#include "random_graph.hpp"
+
+#include <algorithm>
+
+using namespace vc;
+
+// g with its vertices listed in a random order (and renumbered accordingly)
+graph shuffled(const graph& g){
+  vector<uint> order(g.vertices.size());
+  for(uint i = 0; i < order.size(); ++i) order[i] = i;
+  random_shuffle(order.begin(), order.end());
+  graph h;
+  vector<vertex_p> vertices(order.size());
+  for(uint i = 0; i < order.size(); ++i) vertices[order[i]] = h.add_vertex_fast(i, to_string(i));
+  for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v)
+    for(edge_pc e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
+      if(v->id < e->head->id) h.add_edge_fast(vertices[v->id], vertices[e->head->id]);
+  return h;
+}
+
+int main(){
+  srand(1);
+  for(uint round = 0; round < 1000; ++round){
+    const uint n = 1 + rand() % 12;
+    graph g(random_graph(n, (double)rand() / RAND_MAX)), h(shuffled(g));
+    // whether the search gives up does not depend on the labeling, and complete forms do not either
+    bool g_complete, h_complete;
+    const string g_form(canonical_form(g, vector<uint>(), &g_complete)), h_form(canonical_form(h, vector<uint>(), &h_complete));
+    if(g_complete != h_complete || (g_complete && g_form != h_form)){
+      cerr << "the relabeled copy of "<<g<<" gets another canonical form"<<endl;
+      return 1;
+    }
+    // and graphs with the same complete form are isomorphic
+    graph other(random_graph(n, (double)rand() / RAND_MAX));
+    bool other_complete;
+    if(canonical_form(other, vector<uint>(), &other_complete) == g_form && other_complete && g_complete && !isomorphic(other, g)){
+      cerr << g << " and "<<other<<" get the same canonical form"<<endl;
+      return 1;
+    }
+  }
+  // the search on 8 isolated vertices has 8! leaves, so it gives up, while 6 isolated vertices have 720 of them
+  bool complete;
+  canonical_form(random_graph(8, 0), vector<uint>(), &complete);
+  if(complete){
+    cerr << "the search for the canonical form of 8 isolated vertices did not give up"<<endl;
+    return 1;
+  }
+  canonical_form(random_graph(6, 0), vector<uint>(), &complete);
+  if(!complete){
+    cerr << "the search for the canonical form of 6 isolated vertices gave up"<<endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "../util/enumerators.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace vc;
+
+typedef edge_code<MAX_CODE_WORDS> wide_code;
+
+// a random code and the same bits as a vector
+wide_code random_code(vector<bool>& reference){
+  wide_code code;
+  reference.assign(wide_code::max_bits, false);
+  const uint density = 1 + rand() % 8;
+  for(uint bit = 0; bit < wide_code::max_bits; ++bit)
+    if(rand() % density == 0){
+      code.set(bit);
+      reference[bit] = true;
+    }
+  return code;
+}
+
+int main(){
+  srand(1);
+  for(uint round = 0; round < 10000; ++round){
+    vector<bool> a_bits, b_bits;
+    const wide_code a(random_code(a_bits)), b(random_code(b_bits));
+    for(uint bit = 0; bit < wide_code::max_bits; ++bit)
+      if(a.test(bit) != a_bits[bit]){
+        cerr << "bit "<<bit<<" is wrong"<<endl;
+        return 1;
+      }
+    // ranges of bits, also across the words
+    const uint count = 1 + rand() % 63, first = rand() % (wide_code::max_bits - count + 1);
+    uint64_t expected = 0;
+    for(uint j = 0; j < count; ++j) if(a_bits[first + j]) expected |= (uint64_t)1 << j;
+    if(a.bits(first, count) != expected){
+      cerr << "the "<<count<<" bits from "<<first<<" are wrong"<<endl;
+      return 1;
+    }
+    wide_code moved;
+    moved.set_bits(first, expected);
+    for(uint bit = 0; bit < wide_code::max_bits; ++bit)
+      if(moved.test(bit) != (bit >= first && bit < first + count && a_bits[bit])){
+        cerr << "setting the "<<count<<" bits from "<<first<<" sets bit "<<bit<<" wrong"<<endl;
+        return 1;
+      }
+    // codes compare like numbers, the highest bit first
+    uint highest = wide_code::max_bits;
+    while(highest-- > 0 && a_bits[highest] == b_bits[highest]);
+    const bool less = highest < wide_code::max_bits && b_bits[highest];
+    if((a < b) != less || (a == b) != (highest >= wide_code::max_bits)){
+      cerr << "the codes compare wrong"<<endl;
+      return 1;
+    }
+    // going through the bits from the lowest one
+    uint next = 0;
+    for(wide_code rest(a); !rest.empty(); rest.clear_lowest(), ++next){
+      while(!a_bits[next]) ++next;
+      if(rest.lowest() != next){
+        cerr << "the lowest bit is "<<rest.lowest()<<" instead of "<<next<<endl;
+        return 1;
+      }
+    }
+    for(; next < wide_code::max_bits; ++next)
+      if(a_bits[next]){
+        cerr << "bit "<<next<<" was skipped"<<endl;
+        return 1;
+      }
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include "../solv/catalogue.hpp"
+
+#include <climits>
+
+using namespace vc;
+
+// the number of graphs grown with the given bounds has to be the known one
+bool check_count(const uint n, const uint max_degree, const bool connected, const size_t expected){
+  const size_t count(grow_catalogue(n, max_degree, UINT_MAX, connected).size());
+  if(count == expected) return true;
+  cerr << "grew "<<count<<(connected ? " connected" : "")<<" graphs on "<<n<<" vertices of maximum degree "<<max_degree
+       <<" instead of "<<expected<<endl;
+  return false;
+}
+
+// the catalogue computed in the empty cache directory of the test has to be saved and come back the same
+bool check_reload(const uint n){
+  const graph_catalogue computed(n);
+  const graph_catalogue reloaded(n);
+  if(computed.from_file() || !reloaded.from_file() || reloaded.size() != computed.size()){
+    cerr << "the catalogue of the "<<n<<"-vertex graphs was not computed, saved and reloaded in "<<cache_directory()<<endl;
+    return false;
+  }
+  for(size_t i = 0; i < computed.size(); ++i){
+    const catalogue_entry &a(computed.begin()[i]), &b(reloaded.begin()[i]);
+    if(a.code != b.code || a.automorphisms != b.automorphisms || a.vc_num != b.vc_num){
+      cerr << "the reloaded catalogue of the "<<n<<"-vertex graphs differs at "<<i<<endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(){
+  if(!check_reload(6)) return 1;
+  // unions of paths and cycles, the graphs of maximum degree 3 and the connected ones among them
+  if(!check_count(9, 2, false, 70) || !check_count(16, 2, false, 971) || !check_count(16, 2, true, 2)) return 1;
+  if(!check_count(9, 3, false, 1165) || !check_count(9, 3, true, 531) || !check_count(10, 3, true, 1733)) return 1;
+  // the bound on the VC number keeps exactly the classes with small enough VC numbers
+  const vector<grown_entry> all(grow_catalogue(10, 3, UINT_MAX));
+  for(uint max_vc = 0; max_vc <= 6; ++max_vc){
+    size_t expected = 0;
+    for(const grown_entry& entry : all) if(entry.vc_num <= max_vc) ++expected;
+    const size_t count(grow_catalogue(10, 3, max_vc).size());
+    if(count != expected){
+      cerr << "grew "<<count<<" graphs of VC number at most "<<max_vc<<" instead of "<<expected<<endl;
+      return 1;
+    }
+  }
+  return 0;
+}
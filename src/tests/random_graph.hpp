@@ -0,0 +1,21 @@
+#ifndef RANDOM_GRAPH_HPP
+#define RANDOM_GRAPH_HPP
+
+#include "../util/graphs.hpp"
+
+#include <cstdlib>
+
+using namespace vc;
+
+// a random graph with ids 0, 1, ..., n - 1, in which each edge exists with probability 'density'
+inline graph random_graph(const uint n, const double density){
+  graph g;
+  vector<vertex_p> vertices(n);
+  for(uint id = 0; id < n; ++id) vertices[id] = g.add_vertex_fast(id, to_string(id));
+  for(uint u = 0; u < n; ++u)
+    for(uint v = u + 1; v < n; ++v)
+      if(rand() < density * RAND_MAX) g.add_edge_fast(vertices[u], vertices[v]);
+  return g;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include "../util/graphs.hpp"
+#include "../solv/branching.hpp"
+#include "../solv/vc_table.hpp"
+#include "random_graph.hpp"
+
+#include <cstdio>
+
+using namespace vc;
+
+// the table computed in the empty cache directory of the test has to be saved and come back the same
+// when it's loaded again, and a file with another header has to be replaced
+bool check_reload(){
+  const vc_table computed;
+  if(computed.from_file()){
+    cerr << "the cache directory "<<cache_directory()<<" already has a table"<<endl;
+    return false;
+  }
+  const vc_table reloaded;
+  if(!reloaded.from_file()){
+    cerr << "the table was not saved to "<<cache_directory()<<endl;
+    return false;
+  }
+  for(uint64_t code = 0; code < computed.size(); ++code)
+    if(computed[code] != reloaded[code]){
+      cerr << "the reloaded table has "<<reloaded[code]<<" instead of "<<computed[code]<<" for "<<code<<endl;
+      return false;
+    }
+  char name[64];
+  snprintf(name, sizeof(name), VC_TABLE_FILE, (uint)VC_TABLE_VERTICES);
+  const char other_magic[8] = { 'N', 'O', 'T', 'A', 'T', 'A', 'B', 'L' };
+  const byte entry = byte(0);
+  write_table_file(cache_path(name), other_magic, VC_TABLE_VERTICES, &entry, 1, sizeof(byte));
+  if(vc_table().from_file() || !vc_table().from_file()){
+    cerr << "a table file with another header was not replaced"<<endl;
+    return false;
+  }
+  return true;
+}
+
+int main(){
+  srand(1);
+  if(!check_reload()) return 1;
+  // the size-only solver looks up the residual graphs with at most VC_TABLE_VERTICES vertices,
+  // while the one listing the solution never does, so both have to agree
+  for(uint round = 0; round < 2000; ++round){
+    const uint n = 1 + rand() % (VC_TABLE_VERTICES + 4);
+    const graph g(random_graph(n, (double)rand() / RAND_MAX));
+    graph g_size(g), g_list(g);
+    const uint size(run_branching_algo<solution_size_t>(g_size).size());
+    const uint expected(run_branching_algo<solution_t>(g_list).size());
+    if(size != expected){
+      cerr << "the table says "<<size<<", but the VC number of "<<g<<" is "<<expected<<endl;
+      return 1;
+    }
+  }
+  return 0;
+}
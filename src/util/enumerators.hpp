@@ -0,0 +1,372 @@
+#ifndef ENUMERATORS_HPP
+#define ENUMERATORS_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include "defs.hpp"
+
+// the largest number of 64-bit words of a code, so layouts may have up to 64 * MAX_CODE_WORDS edges
+#define MAX_CODE_WORDS 4
+#define MAX_LAYOUT_EDGES (64 * MAX_CODE_WORDS)
+// the largest number of edges of a layout all of whose codes can be counted through (the number of codes has to fit into 64 bits)
+#define MAX_COUNTED_EDGES 63
+
+using namespace std;
+
+namespace vc {
+
+  // a set of edges of a layout, bit i standing for its i'th edge, in W 64-bit words (the lowest bits first)
+  // codes compare like the numbers whose binary representations they are
+  template<uint W>
+  class edge_code {
+    uint64_t words[W];
+  public:
+    static const uint max_bits = 64 * W;
+
+    edge_code() { for(uint i = 0; i < W; ++i) words[i] = 0; }
+    explicit edge_code(const uint64_t low) { words[0] = low; for(uint i = 1; i < W; ++i) words[i] = 0; }
+
+    inline uint64_t word(const uint i) const { return words[i]; }
+    inline bool test(const uint bit) const { return (words[bit / 64] >> (bit % 64)) & 1; }
+    inline void set(const uint bit) { words[bit / 64] |= (uint64_t)1 << (bit % 64); }
+    // the code with 'bit' set in addition
+    inline edge_code with(const uint bit) const {
+      edge_code result(*this);
+      result.set(bit);
+      return result;
+    }
+
+    inline bool empty() const {
+      for(uint i = 0; i < W; ++i) if(words[i]) return false;
+      return true;
+    }
+    // the lowest bit that is set (the code must not be empty)
+    inline uint lowest() const {
+      uint i = 0;
+      while(!words[i]) ++i;
+      return 64 * i + __builtin_ctzll(words[i]);
+    }
+    inline void clear_lowest() {
+      uint i = 0;
+      while(!words[i]) ++i;
+      words[i] &= words[i] - 1;
+    }
+
+    // the 'count' bits starting at bit 'first' (count < 64)
+    inline uint64_t bits(const uint first, const uint count) const {
+      const uint i(first / 64), shift(first % 64);
+      uint64_t result = words[i] >> shift;
+      if(shift + count > 64 && i + 1 < W) result |= words[i + 1] << (64 - shift);
+      return result & (((uint64_t)1 << count) - 1);
+    }
+    // set the bits starting at bit 'first' that are set in 'value'
+    inline void set_bits(const uint first, const uint64_t value) {
+      const uint i(first / 64), shift(first % 64);
+      words[i] |= value << shift;
+      if(shift && i + 1 < W) words[i + 1] |= value >> (64 - shift);
+    }
+
+    inline edge_code operator^(const edge_code& c) const {
+      edge_code result;
+      for(uint i = 0; i < W; ++i) result.words[i] = words[i] ^ c.words[i];
+      return result;
+    }
+    inline bool operator==(const edge_code& c) const {
+      for(uint i = 0; i < W; ++i) if(words[i] != c.words[i]) return false;
+      return true;
+    }
+    inline bool operator!=(const edge_code& c) const { return !(*this == c); }
+    inline bool operator<(const edge_code& c) const {
+      for(uint i = W; i-- > 0;) if(words[i] != c.words[i]) return words[i] < c.words[i];
+      return false;
+    }
+  };
+
+  // the number of words of the codes of layouts with 'num_edges' edges (1, 2 or MAX_CODE_WORDS)
+  inline uint code_words(const uint num_edges){
+    return num_edges <= 64 ? 1 : num_edges <= 128 ? 2 : MAX_CODE_WORDS;
+  }
+
+  // the potential edges of the graphs we enumerate, each of which gets a bit in a code
+  class edge_layout {
+    uint vertices;
+    // endpoints of the edge corresponding to each bit
+    vector<pair<uint, uint> > endpoints;
+
+    edge_layout(const uint num_vertices): vertices(num_vertices), endpoints() {}
+  public:
+    // all edges between 'num_vertices' vertices, except for those between two of the first 'border_size' ones
+    // (the order is the same as the one of the adjacency matrices we used before)
+    edge_layout(const uint num_vertices, const uint border_size): vertices(num_vertices), endpoints() {
+      for(uint i = 0; i < num_vertices; ++i)
+        for(uint j = max(i + 1, border_size); j < num_vertices; ++j)
+          endpoints.push_back(make_pair(i, j));
+      if(endpoints.size() > MAX_LAYOUT_EDGES) FAIL("cannot enumerate graphs with "<<endpoints.size()<<" potential edges");
+    }
+
+    // all edges between the internal vertices 0, 1, ... and the border vertices following them,
+    // bit i * border_size + j stands for the edge between internal vertex i and border vertex j
+    static edge_layout attachments(const uint internal_vertices, const uint border_size){
+      edge_layout result(internal_vertices + border_size);
+      for(uint i = 0; i < internal_vertices; ++i)
+        for(uint j = 0; j < border_size; ++j)
+          result.endpoints.push_back(make_pair(i, internal_vertices + j));
+      if(result.endpoints.size() > MAX_LAYOUT_EDGES) FAIL("cannot enumerate "<<result.endpoints.size()<<" attachment edges");
+      return result;
+    }
+
+    inline uint size() const { return endpoints.size(); }
+    inline uint num_vertices() const { return vertices; }
+    inline const pair<uint, uint>& operator[](const uint bit) const { return endpoints[bit]; }
+
+    // decode 'code' into adjacency rows: bit j of rows[i] is set iff ij is an edge
+    // rows has to have space for num_vertices() entries (and there may be at most 64 vertices)
+    template<class Code>
+    void decode(const Code& code, uint64_t* rows) const {
+      assert(vertices <= 64);
+      for(uint i = 0; i < vertices; ++i) rows[i] = 0;
+      for(uint bit = 0; bit < endpoints.size(); ++bit)
+        if(code.test(bit)){
+          const pair<uint, uint>& e(endpoints[bit]);
+          rows[e.first] |= (uint64_t)1 << e.second;
+          rows[e.second] |= (uint64_t)1 << e.first;
+        }
+    }
+
+    // the code of the graph with the given adjacency rows (the inverse of decode)
+    template<class Code>
+    Code encode(const uint64_t* rows) const {
+      Code code;
+      for(uint bit = 0; bit < endpoints.size(); ++bit)
+        if((rows[endpoints[bit].first] >> endpoints[bit].second) & 1) code.set(bit);
+      return code;
+    }
+  };
+
+  // enumerate a range of codes by counting; the k'th candidate is either k itself or,
+  // in Gray code order, k ^ (k >> 1), which differs from the previous one in exactly one bit
+  class edge_counter {
+    uint64_t first, last;
+  public:
+    class iterator {
+      uint64_t k;
+    public:
+      iterator(const uint64_t _k): k(_k) {}
+
+      // the current candidate in counting order
+      inline uint64_t operator*() const { return k; }
+      // the current candidate in Gray code order
+      inline uint64_t gray() const { return k ^ (k >> 1); }
+      // the bit that was flipped to get from the previous Gray code to the current one
+      inline uint flipped() const { return __builtin_ctzll(k); }
+
+      inline iterator& operator++() { ++k; return *this; }
+      inline bool operator==(const iterator& i) const { return k == i.k; }
+      inline bool operator!=(const iterator& i) const { return k != i.k; }
+    };
+
+    // all codes with 'num_bits' bits (at most MAX_COUNTED_EDGES)
+    edge_counter(const uint num_bits): first(0), last((uint64_t)1 << num_bits) { assert(num_bits <= MAX_COUNTED_EDGES); }
+    // the codes first, first + 1, ..., last - 1
+    edge_counter(const uint64_t _first, const uint64_t _last): first(_first), last(_last) {}
+
+    inline iterator begin() const { return iterator(first); }
+    inline iterator end() const { return iterator(last); }
+    inline uint64_t size() const { return last - first; }
+
+    // split the range into (at most) 'parts' consecutive ranges of roughly equal size
+    vector<edge_counter> split(const uint parts) const {
+      vector<edge_counter> result;
+      const uint64_t part_size = (size() + parts - 1) / parts;
+      for(uint64_t start = first; start < last; start += part_size)
+        result.push_back(edge_counter(start, min(start + part_size, last)));
+      return result;
+    }
+  };
+
+  // restrictions on the graphs we enumerate
+  struct enumeration_constraints {
+    // no vertex may have more than this many neighbors
+    uint max_degree;
+    // the graph (profile vertices included) has to be connected
+    bool connected;
+    // each profile vertex needs a neighbor
+    bool all_border_attached;
+    // each internal vertex needs a neighbor
+    bool no_isolated;
+
+    enumeration_constraints(): max_degree(UINT_MAX), connected(false), all_border_attached(false), no_isolated(false) {}
+
+    inline bool none() const { return max_degree == UINT_MAX && !connected && !all_border_attached && !no_isolated; }
+
+    // the constraints that also hold for all subgraphs of a graph satisfying them
+    inline enumeration_constraints hereditary() const {
+      enumeration_constraints result;
+      result.max_degree = max_degree;
+      return result;
+    }
+
+    // whether the graph with the given adjacency rows on the vertices 0, 1, ..., n - 1 (none of them a
+    // profile vertex, at most 64 of them) satisfies the constraints
+    bool satisfied_by(const uint64_t* rows, const uint n) const {
+      for(uint v = 0; v < n; ++v){
+        if((uint)__builtin_popcountll(rows[v]) > max_degree) return false;
+        if(no_isolated && !rows[v]) return false;
+      }
+      if(connected && n){
+        uint64_t reached = 1, frontier = 1;
+        while(frontier){
+          uint64_t next = 0;
+          for(; frontier; frontier &= frontier - 1) next |= rows[__builtin_ctzll(frontier)];
+          frontier = next & ~reached;
+          reached |= next;
+        }
+        if(reached != (n == 64 ? ~(uint64_t)0 : ((uint64_t)1 << n) - 1)) return false;
+      }
+      return true;
+    }
+  };
+
+  // enumerate the codes of a layout satisfying some constraints by a depth-first search over the edges,
+  // deciding the highest bit first (so the codes come out in increasing order) and never descending
+  // into a subtree whose graphs all violate the constraints
+  // the graphs may extend a fixed graph on the same vertices, given by its edges
+  // if the caller knows that adding edges cannot repair a graph (for example, because some quantity only
+  // grows with the edges), it can pass a test that cuts off the subtree below each code failing it
+  // the codes are of type Code, an edge_code with enough bits for the layout
+  template<class Code>
+  class constrained_enumerator {
+    const edge_layout& layout;
+    const enumeration_constraints constraints;
+    // which vertices are profile vertices
+    const vector<bool> border;
+    const vector<pair<uint, uint> > initial_edges;
+    // finished[b] = vertices whose edges have all been decided once only the bits below b are left
+    vector<vector<uint> > finished;
+
+    // the state of the search: degrees and a union-find structure (without path compression, so
+    // unions can be undone) whose roots know how many vertices of their component are not finished
+    struct state {
+      vector<uint> degree;
+      vector<uint> parent;
+      vector<uint> size;
+      vector<uint> unfinished;
+      uint components;
+
+      state(const uint n): degree(n, 0), parent(n), size(n, 1), unfinished(n, 1), components(n) {
+        for(uint v = 0; v < n; ++v) parent[v] = v;
+      }
+
+      inline uint find(uint v) const {
+        while(parent[v] != v) v = parent[v];
+        return v;
+      }
+      // join the components of u and v, return the root that was attached to the other one (or UINT_MAX)
+      inline uint unite(const uint u, const uint v){
+        uint ru = find(u), rv = find(v);
+        if(ru == rv) return UINT_MAX;
+        if(size[ru] < size[rv]) swap(ru, rv);
+        parent[rv] = ru;
+        size[ru] += size[rv];
+        unfinished[ru] += unfinished[rv];
+        --components;
+        return rv;
+      }
+      inline void undo_unite(const uint rv){
+        const uint ru = parent[rv];
+        parent[rv] = rv;
+        size[ru] -= size[rv];
+        unfinished[ru] -= unfinished[rv];
+        ++components;
+      }
+    };
+
+    // the vertex v cannot get any more edges, return whether the constraints can still be satisfied
+    bool finish(const uint v, state& st) const {
+      --st.unfinished[st.find(v)];
+      if(st.degree[v] == 0 && (border[v] ? constraints.all_border_attached : constraints.no_isolated)) return false;
+      // a component that cannot grow any more has to be everything
+      return !constraints.connected || st.unfinished[st.find(v)] > 0 || st.components == 1;
+    }
+
+    template<class Function, class Test>
+    void visit(const uint bits_left, const Code& code, state& st, const Function& f, const Test& extensible) const {
+      bool feasible = true;
+      uint done = 0;
+      for(const uint v : finished[bits_left]){
+        ++done;
+        if(!(feasible = finish(v, st))) break;
+      }
+      if(feasible){
+        if(bits_left == 0)
+          f(code);
+        else {
+          const uint bit = bits_left - 1;
+          // without the edge...
+          visit(bit, code, st, f, extensible);
+          // ...or with it, if neither of its ends is saturated yet (and the caller does not object)
+          const pair<uint, uint>& e(layout[bit]);
+          const Code with(code.with(bit));
+          if(st.degree[e.first] < constraints.max_degree && st.degree[e.second] < constraints.max_degree && extensible(with)){
+            ++st.degree[e.first]; ++st.degree[e.second];
+            const uint joined = st.unite(e.first, e.second);
+            visit(bit, with, st, f, extensible);
+            if(joined != UINT_MAX) st.undo_unite(joined);
+            --st.degree[e.first]; --st.degree[e.second];
+          }
+        }
+      }
+      for(uint i = 0; i < done; ++i) ++st.unfinished[st.find(finished[bits_left][i])];
+    }
+
+    void init(){
+      if(layout.size() > Code::max_bits) FAIL("cannot enumerate "<<layout.size()<<" edges with "<<Code::max_bits<<"-bit codes");
+      // vertex v is finished when its lowest bit has been decided (or right away if it has no bits)
+      finished.resize(layout.size() + 1);
+      vector<uint> lowest_bit(layout.num_vertices(), layout.size());
+      for(uint bit = layout.size(); bit-- > 0;){
+        lowest_bit[layout[bit].first] = bit;
+        lowest_bit[layout[bit].second] = bit;
+      }
+      for(uint v = 0; v < layout.num_vertices(); ++v) finished[lowest_bit[v]].push_back(v);
+    }
+  public:
+    constrained_enumerator(const edge_layout& _layout, const enumeration_constraints& _constraints, const vector<bool>& _border):
+      layout(_layout), constraints(_constraints), border(_border), initial_edges(), finished() { init(); }
+    constrained_enumerator(const edge_layout& _layout,
+                           const enumeration_constraints& _constraints,
+                           const vector<bool>& _border,
+                           const vector<pair<uint, uint> >& _initial_edges):
+      layout(_layout), constraints(_constraints), border(_border), initial_edges(_initial_edges), finished() { init(); }
+
+    // call f on each code satisfying the constraints, skipping the codes (and all their supersets)
+    // for which extensible(code) is false
+    template<class Function, class Test>
+    void for_each(const Function& f, const Test& extensible) const {
+      if(!extensible(Code())) return;
+      state st(layout.num_vertices());
+      for(const pair<uint, uint>& e : initial_edges){
+        ++st.degree[e.first]; ++st.degree[e.second];
+        st.unite(e.first, e.second);
+      }
+      visit(layout.size(), Code(), st, f, extensible);
+    }
+
+    // call f on each code satisfying the constraints
+    template<class Function>
+    void for_each(const Function& f) const {
+      for_each(f, [](const Code&){ return true; });
+    }
+
+    // all codes satisfying the constraints
+    vector<Code> all() const {
+      vector<Code> result;
+      for_each([&result](const Code& code){ result.push_back(code); });
+      return result;
+    }
+  };
+
+}
+
+#endif
@@ -48,21 +48,22 @@ namespace vc{
   }
 
 
+  // copies keep the vertex ids of the original, so ids can be used across copies
   graph::graph(const graph& g, unordered_map<uint, vertex_p>* id_to_vertex):
     // copy graph infos
-    current_id(-1)
+    current_id(g.current_id)
   {
     DEBUG5(cout << "copy constructing a new graph with "<<g.vertices.size()<<" vertices"<<endl);
-    add_disjointly(g, id_to_vertex);
+    add_disjointly(g, id_to_vertex, true);
   }
 
   // copy constructor - NOTE THAT trr_infos ARE NOT up to date for the copy
   graph::graph(const graph& g, edgelist* const el):
     // copy graph infos
-    current_id(-1)
+    current_id(g.current_id)
   {
     unordered_map<uint, vertex_p> id_to_vertex;
-    add_disjointly(g, &id_to_vertex);
+    add_disjointly(g, &id_to_vertex, true);
     // if we are also tasked with translating the edgelist el, then do so using id_to_vertex
     if(!el->empty()){
       DEBUG4(cout << "translating edgelist "<< *el << " using "<<id_to_vertex<<endl);
@@ -95,13 +96,16 @@ namespace vc{
   // clear the graph (remove all vertices and edges)
   void graph::clear(){
     vertices.clear();
+    id_index.clear();
+    id_present.clear();
   }
 
   // find a vertex by specifying its id, return vertices.end() if its just not there
   vertex_p graph::find_vertex_by_id(const uint id){
-    for(vertex_p i = vertices.begin(); i != vertices.end(); ++i)
-      if(i->id == id) return i;
-    return vertices.end();
+    if(id < id_present.size() && id_present[id])
+      return id_index[id];
+    else
+      return vertices.end();
   }
   vertex_p graph::find_vertex_by_name(const string& s){
     for(vertex_p i = vertices.begin(); i != vertices.end(); ++i)
@@ -123,7 +127,16 @@ namespace vc{
 
   // add a vertex given as id to the graph and return a fresh iterator to it
   vertex_p graph::add_vertex_fast(const uint id){
-    return vertices.insert(vertices.end(), vertex(id));
+    const vertex_p v(vertices.insert(vertices.end(), vertex(id)));
+    if(id >= id_index.size()){
+      id_index.resize(id + 1);
+      id_present.resize(id + 1);
+    }
+    id_index[id] = v;
+    id_present[id] = true;
+    // make sure that fresh ids don't clash with this one
+    current_id = max(current_id, id);
+    return v;
   }
 
   vertex_p graph::add_vertex_fast(const uint id, const string& s){
@@ -183,6 +196,7 @@ namespace vc{
       // delete incident edges
       while(!v->adj_list.empty()) delete_edge(v->adj_list.begin());
       // and remove it from the vertex list
+      id_present[v->id] = false;
       vertices.erase(v);
     }
     void graph::delete_vertices(list<vertex_p>& vl){
@@ -288,13 +302,13 @@ namespace vc{
   }
 
 
-  void graph::add_disjointly(const graph& Gfrom, unordered_map<uint, vertex_p>* id_to_vertex){
+  void graph::add_disjointly(const graph& Gfrom, unordered_map<uint, vertex_p>* id_to_vertex, const bool keep_ids){
     if(Gfrom.vertices.empty()) return;
     const bool destroy_map(id_to_vertex == NULL);
     if(destroy_map) id_to_vertex = new unordered_map<uint, vertex_p>();
     // copy vertices
     for(vertex_pc x = Gfrom.vertices.begin(); x != Gfrom.vertices.end(); ++x){
-      vertex_p y(add_vertex_fast(x->name));
+      vertex_p y(keep_ids ? add_vertex_fast(x->id, x->name) : add_vertex_fast(x->name));
       (*id_to_vertex)[x->id] = y;
       // copy edges involving v
       for(edge_pc e = x->adj_list.begin(); e != x->adj_list.end(); ++e){
@@ -17,8 +17,6 @@
 
 using namespace std;
 
-typedef vector<vector<bool> > AdjMatrix;
-
  
 namespace vc {
 
@@ -152,6 +150,9 @@ namespace vc{
   class graph {
   private:
     void compute_bridges(edgelist& bridgelist, list<uint>& split_off_sizes);
+    // O(1) access to the vertices by their id (ids survive copying)
+    vector<vertex_p> id_index;
+    vector<bool> id_present;
   public:
     uint current_id;
     list<vertex> vertices;
@@ -176,6 +177,7 @@ namespace vc{
     uint num_vertices() const;
 
     // find a vertex by specifying its id, return vertices.end() if its just not there
+    // this is O(1), so use it instead of find_vertex_by_name whenever possible
     vertex_p find_vertex_by_id(const uint id);
     vertex_p find_vertex_by_name(const string& s);
 
@@ -240,7 +242,8 @@ namespace vc{
     void read_from_file(const char* infile);
 
     // add a graph to this one
-    void add_disjointly(const graph& Gfrom, unordered_map<uint, vertex_p>* id_to_vertex = NULL);
+    // if keep_ids is set, the new vertices get the ids of their originals (make sure they don't clash!)
+    void add_disjointly(const graph& Gfrom, unordered_map<uint, vertex_p>* id_to_vertex = NULL, const bool keep_ids = false);
 
 //    void update_subtree_NH();
     // get all degree-one vertices
@@ -1,71 +1,249 @@
 #include "isomorphism.hpp"
 #include <algorithm>
+#include <sstream>
 
 
 namespace vc{
 
-  // take a partial isomorphism (that's relating everyone with degree less than 'degree' and extend it)
-  bool isomorphic_recursive(const degree_map_t& deg_map1,
-                            const degree_map_t& deg_map2,
-                            const degree_map_t::const_iterator current_deg,
-                            isomorphism_t& partial_iso){
-    if(current_deg == deg_map1.end()){
-      // if all degrees are included in partial_iso, check if it is an isomorphism
-      for(auto i = deg_map1.begin(); i != deg_map1.end(); ++i)
-        for(vertex_p v : i->second)
-          for(edge_p e = v->adj_list.begin(); e != v->adj_list.end(); ++e)
-            if(!adjacent(partial_iso[v], partial_iso[e->head])) return false;
-      // if all edges of deg_map1 are represented in deg_map2 and the degrees match up, then its isomorphic
-      return true;
-    } else {
-      // else run thru the possible permutations for the current degree
-      vector<vertex_p> vlist2(deg_map2.at(current_deg->first));
-      vector<vertex_p> vlist1(current_deg->second);
-      // get the first 
-      std::sort(vlist2.begin(), vlist2.end());
-      do {
-        vector<vertex_p>::iterator i = vlist1.begin();
-        vector<vertex_p>::iterator j = vlist2.begin();
-        // assign one of the permutations to the current degree
-        while(i != vlist1.end()){
-          partial_iso[*i] = *j;
-          ++i; ++j;
-        }
-        // recurse for the next degree
-        degree_map_t::const_iterator next(current_deg); ++next;
-        if(isomorphic_recursive(deg_map1, deg_map2, next, partial_iso))
-          return true; // if an isomorphism is found return success
-      } while(std::next_permutation(vlist2.begin(), vlist2.end()));
-      return false;
+  coloured_graph::coloured_graph(const graph& g):
+    n(g.vertices.size()), adjacency(n * n, 0), neighbors(n), colour(n, 0)
+  {
+    // number the vertices by their position in the vertex list
+    uint max_id = 0;
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v) max_id = max(max_id, v->id);
+    vector<uint> index(max_id + 1);
+    uint i = 0;
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v) index[v->id] = i++;
+    i = 0;
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v, ++i)
+      for(edge_pc e = v->adj_list.begin(); e != v->adj_list.end(); ++e){
+        const uint j = index[e->head->id];
+        adjacency[i * n + j] = 1;
+        neighbors[i].push_back(j);
+      }
+  }
+
+  // mix the bits of x, so that sums of mixed values rarely collide
+  inline uint64_t mix(uint64_t x){
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    return x ^ (x >> 33);
+  }
+
+  // the new colour of v is determined by its old colour and the multiset of colours of its neighbors
+  // (we hash them and, in the rare case of a collision, just get a coarser partition, which is still correct)
+  inline uint64_t colour_signature(const coloured_graph& g, const uint v){
+    uint64_t result = mix(g.colour[v]);
+    for(const uint u : g.neighbors[v]) result += mix(((uint64_t)1 << 32) | g.colour[u]);
+    return result;
+  }
+
+  // number of vertices of each colour
+  vector<uint> colour_histogram(const coloured_graph& g, const uint num_colours){
+    vector<uint> result(num_colours, 0);
+    for(const uint c : g.colour) ++result[c];
+    return result;
+  }
+
+  bool refine_colours(coloured_graph& g1, coloured_graph& g2){
+    if(g1.n != g2.n) return false;
+    const uint n = g1.n;
+    uint num_colours = 0;
+    vector<uint64_t> sig(2 * n), sorted(2 * n);
+    while(true){
+      // number the signatures of both graphs in sorted order, so the same signature gets the same colour in both
+      for(uint v = 0; v < n; ++v) sig[v] = colour_signature(g1, v);
+      for(uint v = 0; v < n; ++v) sig[n + v] = colour_signature(g2, v);
+      sorted = sig;
+      sort(sorted.begin(), sorted.end());
+      const uint next_colour = unique(sorted.begin(), sorted.end()) - sorted.begin();
+      for(uint v = 0; v < 2 * n; ++v){
+        const uint c = lower_bound(sorted.begin(), sorted.begin() + next_colour, sig[v]) - sorted.begin();
+        if(v < n) g1.colour[v] = c; else g2.colour[v - n] = c;
+      }
+
+      if(colour_histogram(g1, next_colour) != colour_histogram(g2, next_colour)) return false;
+      // the partition did not get any finer, so it's stable
+      if(next_colour == num_colours) return true;
+      num_colours = next_colour;
+    }
+  }
+
+  // refine the colours of g alone
+  void refine_colours(coloured_graph& g){
+    coloured_graph copy(g);
+    refine_colours(g, copy);
+  }
+
+  bool isomorphic_recursive(const coloured_graph& g1,
+                            const coloured_graph& g2,
+                            const vector<uint>& order,
+                            const uint depth,
+                            vector<uint>& iso,
+                            vector<bool>& used){
+    // if everyone is mapped, then all adjacencies have been checked along the way
+    if(depth == order.size()) return true;
+    const uint v = order[depth];
+    for(uint w = 0; w < g2.n; ++w){
+      if(used[w] || g2.colour[w] != g1.colour[v]) continue;
+      // check the adjacencies to all vertices that are mapped already
+      bool consistent = true;
+      for(uint i = 0; consistent && i < depth; ++i)
+        consistent = (g1.adjacent(v, order[i]) == g2.adjacent(w, iso[order[i]]));
+      if(!consistent) continue;
+      iso[v] = w;
+      used[w] = true;
+      if(isomorphic_recursive(g1, g2, order, depth + 1, iso, used)) return true;
+      used[w] = false;
+    }
+    return false;
+  }
+
+  void all_isomorphisms_recursive(const coloured_graph& g1,
+                                  const coloured_graph& g2,
+                                  const vector<uint>& order,
+                                  const uint depth,
+                                  vector<uint>& iso,
+                                  vector<bool>& used,
+                                  vector<vector<uint> >& result){
+    if(depth == order.size()){
+      result.push_back(iso);
+      return;
     }
+    const uint v = order[depth];
+    for(uint w = 0; w < g2.n; ++w){
+      if(used[w] || g2.colour[w] != g1.colour[v]) continue;
+      bool consistent = true;
+      for(uint i = 0; consistent && i < depth; ++i)
+        consistent = (g1.adjacent(v, order[i]) == g2.adjacent(w, iso[order[i]]));
+      if(!consistent) continue;
+      iso[v] = w;
+      used[w] = true;
+      all_isomorphisms_recursive(g1, g2, order, depth + 1, iso, used, result);
+      used[w] = false;
+    }
+  }
+
+  // the order in which the search maps the vertices of g:
+  // vertices of small colour classes first, since they have the fewest choices
+  vector<uint> search_order(const coloured_graph& g){
+    const vector<uint> class_size(colour_histogram(g, g.n + 1));
+    vector<uint> order(g.n);
+    for(uint v = 0; v < g.n; ++v) order[v] = v;
+    stable_sort(order.begin(), order.end(), [&](const uint u, const uint v){
+        return class_size[g.colour[u]] < class_size[g.colour[v]] ||
+          (class_size[g.colour[u]] == class_size[g.colour[v]] && g.colour[u] < g.colour[v]);
+      });
+    return order;
+  }
+
+  vector<vector<uint> > automorphisms(const graph& g){
+    coloured_graph cg1(g), cg2(g);
+    refine_colours(cg1, cg2);
+    const vector<uint> order(search_order(cg1));
+    vector<uint> iso(cg1.n);
+    vector<bool> used(cg1.n, false);
+    vector<vector<uint> > result;
+    all_isomorphisms_recursive(cg1, cg2, order, 0, iso, used, result);
+    return result;
   }
 
-  bool isomorphic_brute_force(const degree_map_t& deg_map1, const degree_map_t& deg_map2){
-    isomorphism_t iso;
-    return isomorphic_recursive(deg_map1, deg_map2, deg_map1.begin(), iso);
+  bool isomorphic(coloured_graph& g1, coloured_graph& g2){
+    if(!refine_colours(g1, g2)) return false;
+    DEBUG3(cout << "passed colour refinement, going on to search"<<endl);
+
+    const vector<uint> order(search_order(g1));
+    vector<uint> iso(g1.n);
+    vector<bool> used(g2.n, false);
+    return isomorphic_recursive(g1, g2, order, 0, iso, used);
   }
 
   bool isomorphic(graph& g1, graph& g2){
     // check the vertex numbers
     if(g1.vertices.size() != g2.vertices.size()) return false;
 
-    // get the degree maps to speed up isomorphism checking
-    degree_map_t deg_map1, deg_map2;
-    for(vertex_p v = g1.vertices.begin(); v != g1.vertices.end(); ++v)
-      deg_map1[v->degree()].push_back(v);
-    for(vertex_p v = g2.vertices.begin(); v != g2.vertices.end(); ++v)
-      deg_map2[v->degree()].push_back(v);
-
     // check the degree sequences
-    for(auto deg_pair = deg_map1.begin(); deg_pair != deg_map1.end(); ++deg_pair)
-      if(deg_map2[deg_pair->first].size() != deg_pair->second.size())
-        return false; // number of vertices of degree deg_pair->first in g1 and g2 differ
+    vector<uint> degrees1, degrees2;
+    for(vertex_pc v = g1.vertices.begin(); v != g1.vertices.end(); ++v) degrees1.push_back(v->degree());
+    for(vertex_pc v = g2.vertices.begin(); v != g2.vertices.end(); ++v) degrees2.push_back(v->degree());
+    sort(degrees1.begin(), degrees1.end());
+    sort(degrees2.begin(), degrees2.end());
+    if(degrees1 != degrees2) return false;
 
-    DEBUG3(cout << g2 << " passed easy tests, going on to brute force"<<endl);
-
-    bool result = isomorphic_brute_force(deg_map1, deg_map2);
+    coloured_graph cg1(g1), cg2(g2);
+    const bool result = isomorphic(cg1, cg2);
     DEBUG3(cout << "isomorphic? "<<result<<endl);
     return result;
   }
 
+  // a relabeling of g: the new labels of the border vertices and the relabeled edges
+  typedef pair<vector<uint>, vector<pair<uint, uint> > > relabeling;
+
+  // relabel each vertex of g by its colour (all colours are distinct)
+  relabeling relabel(const coloured_graph& g, const vector<uint>& border){
+    relabeling result;
+    for(const uint b : border) result.first.push_back(g.colour[b]);
+    for(uint v = 0; v < g.n; ++v)
+      for(const uint u : g.neighbors[v])
+        if(g.colour[u] < g.colour[v]) result.second.push_back(make_pair(g.colour[u], g.colour[v]));
+    sort(result.second.begin(), result.second.end());
+    return result;
+  }
+
+  // refine the colours of g and, if some colour class has more than one vertex, branch on the vertex of the
+  // smallest such class that gets a colour of its own; each leaf of the search tree gives a relabeling of g,
+  // and we keep the smallest one (if we run out of labelings with branches left to try, 'truncated' is set)
+  void canonical_search(coloured_graph& g, const vector<uint>& border, uint& labelings_left, bool& truncated, relabeling& best){
+    refine_colours(g);
+    const vector<uint> class_size(colour_histogram(g, g.n));
+    uint branch_colour = UINT_MAX;
+    for(uint c = 0; c < g.n; ++c)
+      if(class_size[c] > 1 && (branch_colour == UINT_MAX || class_size[c] < class_size[branch_colour])) branch_colour = c;
+    if(branch_colour == UINT_MAX){
+      const relabeling leaf(relabel(g, border));
+      if(labelings_left == CANONICAL_MAX_LABELINGS || leaf < best) best = leaf;
+      --labelings_left;
+      return;
+    }
+    for(uint v = 0; v < g.n; ++v)
+      if(g.colour[v] == branch_colour){
+        if(!labelings_left){
+          truncated = true;
+          return;
+        }
+        coloured_graph h(g);
+        // no vertex has colour n, so v is the only one
+        h.colour[v] = g.n;
+        canonical_search(h, border, labelings_left, truncated, best);
+      }
+  }
+
+  string canonical_form(const graph& g, const vector<uint>& border, bool* complete){
+    coloured_graph cg(g);
+    // number the border vertices by their position in the vertex list and give them colours of their own,
+    // in the order of the border
+    vector<uint> border_index(border.size());
+    uint i = 0;
+    for(vertex_pc v = g.vertices.begin(); v != g.vertices.end(); ++v, ++i){
+      const vector<uint>::const_iterator it(find(border.begin(), border.end(), v->id));
+      if(it != border.end()){
+        border_index[it - border.begin()] = i;
+        cg.colour[i] = 1 + (it - border.begin());
+      }
+    }
+    uint labelings_left = CANONICAL_MAX_LABELINGS;
+    bool truncated = false;
+    relabeling best;
+    canonical_search(cg, border_index, labelings_left, truncated, best);
+    if(complete) *complete = !truncated;
+    ostringstream result;
+    result << cg.n << " border";
+    for(const uint b : best.first) result << " " << b;
+    result << " edges";
+    for(const pair<uint, uint>& e : best.second) result << " " << e.first << "-" << e.second;
+    return result.str();
+  }
+
 }
@@ -4,23 +4,65 @@
 #include "defs.hpp"
 #include "graphs.hpp"
 
+// the search for the canonical form gives up after this many labelings (and returns the best one so far)
+#define CANONICAL_MAX_LABELINGS 1024
+
 namespace vc{
 
-  typedef map<uint, vector<vertex_p> >  degree_map_t;
-  typedef map<vertex_p, vertex_p> isomorphism_t;
+  // a graph whose vertices are numbered 0, 1, ..., n - 1 (in the order of its vertex list),
+  // with a flat adjacency matrix and a colour for each vertex
+  struct coloured_graph {
+    uint n;
+    vector<char> adjacency;
+    vector<vector<uint> > neighbors;
+    vector<uint> colour;
+
+    // all vertices get the colour 0
+    coloured_graph(const graph& g);
+
+    inline bool adjacent(const uint u, const uint v) const { return adjacency[u * n + v]; }
+  };
 
+  // refine the colours of g1 and g2 simultaneously until they are stable (1-dimensional Weisfeiler-Lehman):
+  // two vertices keep the same colour iff they had the same colour and the same number of neighbors of each colour
+  // the colours are numbered consistently in both graphs, so vertices of the same colour are the only candidates
+  // to be mapped to each other by an isomorphism respecting the initial colours
+  // return false if the colour classes of g1 and g2 differ in size (so they cannot be isomorphic)
+  bool refine_colours(coloured_graph& g1, coloured_graph& g2);
 
-  // take a partial isomorphism (that's relating everyone with degree less than 'degree' and extend it)
-  bool isomorphic_recursive(const degree_map_t& deg_map1,
-                            const degree_map_t& deg_map2,
-                            const degree_map_t::const_iterator current_deg,
-                            isomorphism_t& partial_iso);
+  // take a partial isomorphism iso that maps the first 'depth' vertices of 'order' and extend it,
+  // only mapping vertices to unused vertices of the same colour whose adjacencies to the mapped vertices agree
+  bool isomorphic_recursive(const coloured_graph& g1,
+                            const coloured_graph& g2,
+                            const vector<uint>& order,
+                            const uint depth,
+                            vector<uint>& iso,
+                            vector<bool>& used);
 
-  
-  bool isomorphic_brute_force(const degree_map_t& deg_map1, const degree_map_t& deg_map2);
+  // add all extensions of the partial isomorphism iso (mapping the first 'depth' vertices of 'order') to 'result'
+  void all_isomorphisms_recursive(const coloured_graph& g1,
+                                  const coloured_graph& g2,
+                                  const vector<uint>& order,
+                                  const uint depth,
+                                  vector<uint>& iso,
+                                  vector<bool>& used,
+                                  vector<vector<uint> >& result);
+
+  // all automorphisms of g, each given by the images of the vertices 0, 1, ..., n - 1 (numbered as in the vertex list)
+  vector<vector<uint> > automorphisms(const graph& g);
+
+  // test whether there is an isomorphism between g1 and g2 respecting their colours
+  bool isomorphic(coloured_graph& g1, coloured_graph& g2);
 
   bool isomorphic(graph& g1, graph& g2);
 
+  // a description of g such that two graphs with the same description are isomorphic by an isomorphism
+  // mapping the i-th vertex of 'border' to the i-th vertex of the other border, for all i
+  // (a string listing the edges of g relabeled by individualization and refinement; if the search
+  // exceeds CANONICAL_MAX_LABELINGS, isomorphic graphs may get different descriptions, and *complete
+  // is set to false if given; whether that happens does not depend on the labeling of g)
+  string canonical_form(const graph& g, const vector<uint>& border, bool* complete = NULL);
+
 
 }
 
@@ -0,0 +1,101 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace vc {
+
+  mapped_file::~mapped_file(){
+    if(data) munmap(data, size);
+  }
+
+  bool mapped_file::open(const string& filename, const char magic[8], const uint32_t parameter, const size_t entry_size){
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat info;
+    if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(table_header)){
+      close(fd);
+      return false;
+    }
+    void* const file = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(file == MAP_FAILED) return false;
+    // check that the file is a complete table of the right kind
+    const table_header* const header((const table_header*)file);
+    if(memcmp(header->magic, magic, sizeof(header->magic)) != 0 || header->parameter != parameter ||
+       (size_t)info.st_size != sizeof(table_header) + header->count * entry_size){
+      munmap(file, info.st_size);
+      return false;
+    }
+    if(data) munmap(data, size);
+    data = file;
+    size = info.st_size;
+    return true;
+  }
+
+  bool write_table_file(const string& filename, const char magic[8], const uint32_t parameter,
+                        const void* entries, const uint32_t count, const size_t entry_size){
+    table_header header;
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.parameter = parameter;
+    header.count = count;
+    vector<pair<const void*, size_t> > parts;
+    parts.push_back(make_pair((const void*)&header, sizeof(header)));
+    parts.push_back(make_pair(entries, count * entry_size));
+    return atomic_write(filename, parts);
+  }
+
+  // create the directory 'path' and its missing parents, return whether it exists in the end
+  bool make_directories(const string& path){
+    if(path.empty() || mkdir(path.c_str(), 0755) == 0 || errno == EEXIST) return true;
+    if(errno != ENOENT) return false;
+    const size_t slash = path.find_last_of('/');
+    return slash != string::npos && slash > 0 && make_directories(path.substr(0, slash)) && mkdir(path.c_str(), 0755) == 0;
+  }
+
+  bool atomic_write(const string& filename, const vector<pair<const void*, size_t> >& parts){
+    const size_t slash = filename.find_last_of('/');
+    if(slash != string::npos && !make_directories(filename.substr(0, slash))) return false;
+    const string tmp_name(filename + "." + to_string(getpid()));
+    ofstream f(tmp_name.c_str(), ios::binary);
+    for(const pair<const void*, size_t>& part : parts)
+      f.write((const char*)part.first, part.second);
+    if(f && (f.close(), !f.fail()) && rename(tmp_name.c_str(), filename.c_str()) == 0) return true;
+    remove(tmp_name.c_str());
+    return false;
+  }
+
+  string& cache_directory_setting(){
+    static string directory;
+    return directory;
+  }
+
+  const string& cache_directory(){
+    string& directory(cache_directory_setting());
+    if(directory.empty()){
+      const char* const explicit_dir = getenv(CACHE_DIR_VARIABLE);
+      const char* const xdg_cache = getenv("XDG_CACHE_HOME");
+      const char* const home = getenv("HOME");
+      if(explicit_dir && *explicit_dir) directory = explicit_dir;
+      else if(xdg_cache && *xdg_cache) directory = string(xdg_cache) + "/" CACHE_DIR_NAME;
+      else if(home && *home) directory = string(home) + "/.cache/" CACHE_DIR_NAME;
+      else directory = CACHE_DIR_NAME "_cache";
+    }
+    return directory;
+  }
+
+  void set_cache_directory(const string& directory){
+    cache_directory_setting() = directory;
+  }
+
+  string cache_path(const string& name){
+    return cache_directory() + "/" + name;
+  }
+
+}
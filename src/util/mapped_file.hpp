@@ -0,0 +1,67 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "defs.hpp"
+
+// the environment variable naming the directory of the cached tables and results
+#define CACHE_DIR_VARIABLE "VC_DEG_CACHE_DIR"
+// the subdirectory of $XDG_CACHE_HOME (or ~/.cache) they are kept in otherwise
+#define CACHE_DIR_NAME "vc_deg"
+
+using namespace std;
+
+namespace vc {
+
+  // the header of a file holding a table: a magic string telling what kind of table it is (and which
+  // version of its format), the parameter the table was computed for, and the number of its entries
+  struct table_header {
+    char magic[8];
+    uint32_t parameter;
+    uint32_t count;
+  };
+
+  // a read-only memory mapping of a table file (a table_header followed by the entries)
+  class mapped_file {
+    void* data;
+    size_t size;
+
+    mapped_file(const mapped_file&);
+  public:
+    mapped_file(): data(NULL), size(0) {}
+    ~mapped_file();
+
+    // map 'filename' if its header has the given magic and parameter and the header is followed by exactly
+    // 'count' entries of 'entry_size' bytes, return whether this worked
+    bool open(const string& filename, const char magic[8], const uint32_t parameter, const size_t entry_size);
+
+    inline const table_header& header() const { return *(const table_header*)data; }
+    inline const void* entries() const { return (const table_header*)data + 1; }
+  };
+
+  // write a table file with the given header fields, followed by 'count' entries of 'entry_size' bytes from 'entries'
+  // (it's written to a temporary file first, which is then renamed, so no one ever maps a half-written table);
+  // return whether this worked
+  bool write_table_file(const string& filename, const char magic[8], const uint32_t parameter,
+                        const void* entries, const uint32_t count, const size_t entry_size);
+
+  // replace the file 'filename' by the concatenation of 'parts' (each given by its start and length),
+  // writing them to a temporary file first, which is then renamed, so no one ever reads a half-written file;
+  // missing directories on the way to 'filename' are created;
+  // return whether this worked (if not, 'filename' is left as it was)
+  bool atomic_write(const string& filename, const vector<pair<const void*, size_t> >& parts);
+
+  // the directory of all caches: the one set by set_cache_directory(), otherwise $VC_DEG_CACHE_DIR, otherwise
+  // $XDG_CACHE_HOME/vc_deg, otherwise ~/.cache/vc_deg (and "vc_deg_cache" in the working directory if there is no home)
+  const string& cache_directory();
+  // use 'directory' for all caches (before any of them is used)
+  void set_cache_directory(const string& directory);
+  // the path of the file 'name' in the cache directory
+  string cache_path(const string& name);
+
+}
+
+#endif
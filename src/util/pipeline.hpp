@@ -0,0 +1,254 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "defs.hpp"
+
+// how often a waiting producer or consumer retries before it goes to sleep
+#define PIPELINE_SPIN_ROUNDS 64
+
+using namespace std;
+
+namespace vc {
+
+  // a bounded lock-free multi-producer multi-consumer queue connecting two stages of a pipeline
+  // (after Dmitry Vyukov's bounded MPMC queue: each cell carries a sequence number telling
+  //  producers and consumers whose turn it is, so they only ever compete for the position counters)
+  // waiting producers and consumers retry PIPELINE_SPIN_ROUNDS times and then sleep until the other side
+  // (or closing the queue) wakes them up, so stalled stages don't keep the cores busy
+  template<class T>
+  class bounded_queue {
+    struct cell {
+      atomic<size_t> sequence;
+      T data;
+    };
+
+    const string name;
+    const size_t mask;
+    unique_ptr<cell[]> buffer;
+    atomic<size_t> enqueue_pos;
+    atomic<size_t> dequeue_pos;
+    atomic<bool> closed;
+
+    // sleeping producers wait for not_full, sleeping consumers for not_empty
+    mutex sleep_mutex;
+    condition_variable not_full;
+    condition_variable not_empty;
+    atomic<size_t> sleeping_producers;
+    atomic<size_t> sleeping_consumers;
+
+    // metrics: how full did the queue get and how often did producers/consumers have to wait (and sleep)
+    atomic<size_t> max_depth;
+    atomic<size_t> producer_stalls;
+    atomic<size_t> consumer_stalls;
+    atomic<size_t> producer_sleeps;
+    atomic<size_t> consumer_sleeps;
+
+    // wake one of the sleepers waiting on cv, if there are any
+    // (the fence pairs with the one in sleep(): either the sleeper sees our change or we see the sleeper)
+    void wake(condition_variable& cv, const atomic<size_t>& sleepers){
+      atomic_thread_fence(memory_order_seq_cst);
+      if(sleepers == 0) return;
+      lock_guard<mutex> lock(sleep_mutex);
+      cv.notify_one();
+    }
+
+    // sleep on cv until done() returns true (it's checked with the lock held, so no wake-up gets lost)
+    template<class Predicate>
+    void sleep(condition_variable& cv, atomic<size_t>& sleepers, Predicate done){
+      unique_lock<mutex> lock(sleep_mutex);
+      ++sleepers;
+      atomic_thread_fence(memory_order_seq_cst);
+      cv.wait(lock, done);
+      --sleepers;
+    }
+
+    bool push_without_waking(const T& x){
+      size_t pos = enqueue_pos.load(memory_order_relaxed);
+      while(true){
+        cell& c(buffer[pos & mask]);
+        const size_t seq = c.sequence.load(memory_order_acquire);
+        const long diff = (long)seq - (long)pos;
+        if(diff == 0){
+          // the cell is free, try to claim it
+          if(enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+            c.data = x;
+            c.sequence.store(pos + 1, memory_order_release);
+            // update the metrics
+            const size_t current_depth = depth();
+            size_t old_max = max_depth;
+            while(current_depth > old_max && !max_depth.compare_exchange_weak(old_max, current_depth));
+            return true;
+          }
+        } else if(diff < 0) return false; // full
+        else pos = enqueue_pos.load(memory_order_relaxed);
+      }
+    }
+
+    bool pop_without_waking(T& x){
+      size_t pos = dequeue_pos.load(memory_order_relaxed);
+      while(true){
+        cell& c(buffer[pos & mask]);
+        const size_t seq = c.sequence.load(memory_order_acquire);
+        const long diff = (long)seq - (long)(pos + 1);
+        if(diff == 0){
+          // the cell is filled, try to claim it
+          if(dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+            x = c.data;
+            c.sequence.store(pos + mask + 1, memory_order_release);
+            return true;
+          }
+        } else if(diff < 0) return false; // empty
+        else pos = dequeue_pos.load(memory_order_relaxed);
+      }
+    }
+
+  public:
+    // capacity has to be a power of 2
+    bounded_queue(const string& _name, const size_t capacity):
+      name(_name), mask(capacity - 1), buffer(new cell[capacity]),
+      enqueue_pos(0), dequeue_pos(0), closed(false),
+      sleeping_producers(0), sleeping_consumers(0),
+      max_depth(0), producer_stalls(0), consumer_stalls(0), producer_sleeps(0), consumer_sleeps(0)
+    {
+      assert((capacity & mask) == 0);
+      for(size_t i = 0; i < capacity; ++i) buffer[i].sequence = i;
+    }
+
+    bool try_push(const T& x){
+      if(!push_without_waking(x)) return false;
+      wake(not_empty, sleeping_consumers);
+      return true;
+    }
+
+    bool try_pop(T& x){
+      if(!pop_without_waking(x)) return false;
+      wake(not_full, sleeping_producers);
+      return true;
+    }
+
+    // push x, waiting for space if the queue is full
+    void push(const T& x){
+      if(try_push(x)) return;
+      ++producer_stalls;
+      for(uint round = 0; round < PIPELINE_SPIN_ROUNDS; ++round){
+        this_thread::yield();
+        if(try_push(x)) return;
+      }
+      ++producer_sleeps;
+      sleep(not_full, sleeping_producers, [&](){ return push_without_waking(x); });
+      wake(not_empty, sleeping_consumers);
+    }
+
+    // pop into x, waiting for an element if the queue is empty
+    // return false if the queue is closed and empty
+    bool pop(T& x){
+      if(try_pop(x)) return true;
+      ++consumer_stalls;
+      for(uint round = 0; round < PIPELINE_SPIN_ROUNDS; ++round){
+        if(try_pop(x)) return true;
+        // nothing will be pushed after closing, so try one last time
+        if(closed) return try_pop(x);
+        this_thread::yield();
+      }
+      ++consumer_sleeps;
+      bool popped = false;
+      sleep(not_empty, sleeping_consumers, [&](){
+          popped = pop_without_waking(x) || (closed && pop_without_waking(x));
+          return popped || closed;
+        });
+      if(popped) wake(not_full, sleeping_producers);
+      return popped;
+    }
+
+    // signal the consumers that nothing more is coming and wake everyone who sleeps
+    void close(){
+      {
+        lock_guard<mutex> lock(sleep_mutex);
+        closed = true;
+      }
+      not_empty.notify_all();
+      not_full.notify_all();
+    }
+
+    inline size_t depth() const { return enqueue_pos.load(memory_order_relaxed) - dequeue_pos.load(memory_order_relaxed); }
+
+    void print_metrics(ostream& os) const {
+      os << "queue "<<name<<": "<<enqueue_pos<<" items, max depth "<<max_depth
+         <<", producers waited "<<producer_stalls<<" times (slept "<<producer_sleeps<<"), consumers waited "
+         <<consumer_stalls<<" times (slept "<<consumer_sleeps<<")"<<endl;
+    }
+  };
+
+  // the items of a pipeline are numbered 0, 1, ... by its first stage and may overtake each other in the
+  // parallel stages; a single consumer at the end puts them back in order in a ring of 'capacity' slots
+  // the first stage reserves the slot of each item before creating it, waiting until the item 'capacity'
+  // places before it has been released, so the items overtaking a slow one cannot pile up
+  template<class T>
+  class reorder_buffer {
+    const string name;
+    // the item with number seq goes to slots[seq % capacity]
+    vector<T> slots;
+    vector<bool> filled;
+    // the number of the next item to release (only changed by the consumer, with the lock held)
+    uint64_t next;
+
+    mutex window_mutex;
+    condition_variable window_moved;
+
+    // metrics: how often did the first stage have to wait and how many items were held back at once
+    size_t reserve_stalls;
+    size_t held;
+    size_t max_held;
+
+  public:
+    reorder_buffer(const string& _name, const size_t capacity):
+      name(_name), slots(capacity), filled(capacity, false), next(0), window_mutex(), window_moved(),
+      reserve_stalls(0), held(0), max_held(0) {}
+
+    // wait until the item with number seq fits into the ring
+    void reserve(const uint64_t seq){
+      unique_lock<mutex> lock(window_mutex);
+      if(seq < next + slots.size()) return;
+      ++reserve_stalls;
+      window_moved.wait(lock, [&](){ return seq < next + slots.size(); });
+    }
+
+    // put the item with number seq into its slot (reserved before) and call f on the items that are now
+    // in order, releasing their slots (only one thread may insert)
+    template<class Function>
+    void insert(const uint64_t seq, const T& item, const Function& f){
+      assert(seq >= next && seq < next + slots.size());
+      slots[seq % slots.size()] = item;
+      filled[seq % slots.size()] = true;
+      max_held = max(max_held, ++held);
+      while(filled[next % slots.size()]){
+        const T ready(slots[next % slots.size()]);
+        filled[next % slots.size()] = false;
+        --held;
+        {
+          lock_guard<mutex> lock(window_mutex);
+          ++next;
+        }
+        window_moved.notify_one();
+        f(ready);
+      }
+    }
+
+    void print_metrics(ostream& os) const {
+      os << "reorder buffer "<<name<<": "<<next<<" items in order, at most "<<max_held<<" of "<<slots.size()
+         <<" slots used, the first stage waited "<<reserve_stalls<<" times"<<endl;
+    }
+  };
+
+}
+
+#endif
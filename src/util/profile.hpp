@@ -1,6 +1,10 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+
 namespace vc {
 
   // a profile maps a bit-array (uint) S to an integer j as follows:
@@ -9,16 +13,113 @@ namespace vc {
   // the graph in order to complete the vertex cover
   typedef vector<uint> profile_t;
 
+  // a profile whose entries are recomputed only when they got invalid because the graph changed
+  struct profile_cache {
+    profile_t values;
+    vector<bool> valid;
+    // the order in which to compute the entries: by the lattice of border subsets from the bottom,
+    // so that the entries of all subsets are known when we get to a superset (the entry of the
+    // empty subset comes first, it's cheap since all neighborhoods of the border are selected)
+    vector<uint> order;
+
+    profile_cache(const uint size): values(size), valid(size, false), order(size) {
+      for(uint index = 0; index < size; ++index) order[index] = index;
+      stable_sort(order.begin(), order.end(), [](const uint a, const uint b){
+          return __builtin_popcount(a) < __builtin_popcount(b);
+        });
+    }
+
+    // bounds on entry 'index' implied by the valid entries of its neighbors in the lattice: if the
+    // border vertex X_i with degree d_i joins the subset, the entry does not grow and shrinks by at most d_i
+    // border_degrees[i] = d_i (if it's empty, there are no bounds)
+    pair<uint, uint> bounds(const uint index, const vector<uint>& border_degrees) const {
+      uint lower = 0, upper = UINT_MAX;
+      for(uint i = 0; i < border_degrees.size(); ++i){
+        const uint neighbor(index ^ (1 << i));
+        if(!valid[neighbor]) continue;
+        if(index & (1 << i)){
+          // X_i is in the subset, the neighbor is the smaller subset
+          upper = min(upper, values[neighbor]);
+          lower = max(lower, values[neighbor] - min(values[neighbor], border_degrees[i]));
+        } else {
+          lower = max(lower, values[neighbor]);
+          upper = min(upper, values[neighbor] + border_degrees[i]);
+        }
+      }
+      return make_pair(lower, upper);
+    }
+
+    void invalidate_all(){
+      valid.assign(valid.size(), false);
+    }
+    // the edges of border vertex i changed, which doesn't affect the entries in which all of its
+    // neighbors are in the VC anyways (that is, the entries whose index has bit i set)
+    void invalidate_border(const uint i){
+      for(uint index = 0; index < valid.size(); ++index)
+        if(!(index & (1 << i))) valid[index] = false;
+    }
+  };
+
+  // statistics on the entries at which candidates fail to match a target profile, shared by all threads
+  // checking candidates against this target
+  // for a given target and internal graph, mismatches cluster on a few entries, so checking those first
+  // gets the number of solves per rejected candidate down towards 1
+  class rejection_statistics {
+    // checked[index] = number of times entry 'index' was compared to the target,
+    // rejected[index] = number of times it mismatched
+    vector<atomic<uint64_t> > checked, rejected;
+  public:
+    atomic<uint64_t> candidates;
+    atomic<uint64_t> rejections;
+    // entries solved for candidates that were rejected in the end
+    atomic<uint64_t> rejection_solves;
+
+    rejection_statistics(const uint size): checked(size), rejected(size), candidates(0), rejections(0), rejection_solves(0) {
+      for(uint index = 0; index < size; ++index) checked[index] = rejected[index] = 0;
+    }
+
+    inline void record_check(const uint index, const bool mismatch){
+      checked[index].fetch_add(1, memory_order_relaxed);
+      if(mismatch) rejected[index].fetch_add(1, memory_order_relaxed);
+    }
+    inline void record_candidate(const bool match, const uint solves){
+      candidates.fetch_add(1, memory_order_relaxed);
+      if(!match){
+        rejections.fetch_add(1, memory_order_relaxed);
+        rejection_solves.fetch_add(solves, memory_order_relaxed);
+      }
+    }
+
+    // write the order in which to check the entries into 'order': the entries rejecting the largest fraction
+    // of the candidates reaching them first and, among equally good ones, the entries in the order of 'lattice'
+    // (checking an entry before its subsets loses the bounds they would give it, so an entry is moved ahead
+    // of the lattice order only if it rejected candidates more often)
+    void suggest_order(const vector<uint>& lattice, vector<uint>& order) const {
+      vector<double> rate(checked.size());
+      for(uint index = 0; index < checked.size(); ++index)
+        rate[index] = (rejected[index] + 1.0) / (checked[index] + 2.0);
+      order = lattice;
+      stable_sort(order.begin(), order.end(), [&rate](const uint a, const uint b){ return rate[a] > rate[b]; });
+    }
+
+    void print(ostream& os) const {
+      os << "checked "<<candidates<<" candidates, rejected "<<rejections<<" with "
+         <<(rejections ? (double)rejection_solves / rejections : 0.0)<<" solves on average"<<endl;
+      os << "rejections per entry:";
+      for(uint index = 0; index < rejected.size(); ++index) os << " "<<rejected[index]<<"/"<<checked[index];
+      os << endl;
+    }
+  };
+
   // hash computation for profiles
   class profile_hasher{
     public:
-    uint operator()(const profile_t& p) const{
-      uint result = 0;
-      const uint profile_size = p.size();
-      const uint bits_per_record = 8 * sizeof(uint) / profile_size;
-      const uint lower_mask = (1 << bits_per_record) - 1;
-      for(uint i = 0; i < profile_size; ++i)
-        result |= ( p[i] && lower_mask  ) << (i * bits_per_record);
+    size_t operator()(const profile_t& p) const{
+      // mix in all entries, so profiles differing in any entry tend to get different hashes
+      // (64 bits, so even the many profiles of large borders rarely collide)
+      uint64_t result = p.size();
+      for(uint i = 0; i < p.size(); ++i)
+        result = (result ^ p[i]) * 0x100000001b3ull;
       return result;
     }
   };
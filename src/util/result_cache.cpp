@@ -0,0 +1,87 @@
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+namespace vc {
+
+  // FNV-1a of 'length' bytes at 'data', continuing from 'hash'
+  uint64_t fnv_hash(const char* data, const size_t length, uint64_t hash = 0xcbf29ce484222325ull){
+    for(size_t i = 0; i < length; ++i) hash = (hash ^ (unsigned char)data[i]) * 0x100000001b3ull;
+    return hash;
+  }
+
+  string hex(const uint64_t hash){
+    char result[17];
+    snprintf(result, sizeof(result), "%016llx", (unsigned long long)hash);
+    return result;
+  }
+
+  string result_cache::path_of(const string& key) const{
+    return directory + "/" + hex(fnv_hash(key.data(), key.size()));
+  }
+
+  bool result_cache::lookup(const string& key, string& value) const{
+    const string path(path_of(key));
+    ifstream f(path.c_str(), ios::binary);
+    string stored_key;
+    if(!getline(f, stored_key) || stored_key != key) return false;
+    ostringstream contents;
+    contents << f.rdbuf();
+    value = contents.str();
+    // mark the file as recently used
+    utime(path.c_str(), NULL);
+    return true;
+  }
+
+  void result_cache::store(const string& key, const string& value) const{
+    const string path(path_of(key));
+    const string line_break("\n");
+    vector<pair<const void*, size_t> > parts;
+    parts.push_back(make_pair((const void*)key.data(), key.size()));
+    parts.push_back(make_pair((const void*)line_break.data(), line_break.size()));
+    parts.push_back(make_pair((const void*)value.data(), value.size()));
+    if(atomic_write(path, parts))
+      evict();
+    else
+      DEBUG1(cerr << "could not save the result to "<<path<<endl);
+  }
+
+  void result_cache::evict() const{
+    DIR* const dir = opendir(directory.c_str());
+    if(!dir) return;
+    // (modification time in nanoseconds, size, path) of each file
+    vector<pair<uint64_t, pair<uint64_t, string> > > files;
+    uint64_t total = 0;
+    for(const dirent* entry = readdir(dir); entry; entry = readdir(dir)){
+      const string path(directory + "/" + entry->d_name);
+      struct stat info;
+      if(stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+      const uint64_t modified = (uint64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+      files.push_back(make_pair(modified, make_pair((uint64_t)info.st_size, path)));
+      total += info.st_size;
+    }
+    closedir(dir);
+    sort(files.begin(), files.end());
+    for(uint i = 0; total > max_bytes && i < files.size(); ++i)
+      if(remove(files[i].second.second.c_str()) == 0){
+        DEBUG2(cerr << "evicted "<<files[i].second.second<<" from the result cache"<<endl);
+        total -= files[i].second.first;
+      }
+  }
+
+  string program_fingerprint(){
+    ifstream f("/proc/self/exe", ios::binary);
+    if(!f) return "";
+    uint64_t hash = fnv_hash(NULL, 0);
+    char buffer[1 << 16];
+    while(f.read(buffer, sizeof(buffer)) || f.gcount() > 0) hash = fnv_hash(buffer, f.gcount(), hash);
+    return hex(hash);
+  }
+
+}
@@ -0,0 +1,68 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <stdint.h>
+#include <streambuf>
+#include <string>
+
+#include "defs.hpp"
+#include "mapped_file.hpp"
+
+// the subdirectory of the cache directory the results are cached in
+#define RESULT_CACHE_SUBDIR "results"
+// when the files in the cache directory get larger than this in total, the least recently used ones are removed
+#ifndef RESULT_CACHE_MAX_BYTES
+#define RESULT_CACHE_MAX_BYTES ((uint64_t)64 << 20)
+#endif
+
+using namespace std;
+
+namespace vc {
+
+  // a directory of files mapping keys to values: the file of a key is named by the hash of the key and
+  // holds the key (to tell apart keys with the same hash) followed by the value;
+  // the modification time of a file is the last time it was used, so the oldest files go first
+  class result_cache {
+    const string directory;
+    const uint64_t max_bytes;
+
+    string path_of(const string& key) const;
+    // remove the least recently used files until the total size is at most max_bytes
+    void evict() const;
+  public:
+    result_cache(const string& _directory = cache_path(RESULT_CACHE_SUBDIR), const uint64_t _max_bytes = RESULT_CACHE_MAX_BYTES):
+      directory(_directory), max_bytes(_max_bytes) {}
+
+    // if 'key' is in the cache, put its value into 'value' and return true
+    // the key must not contain a line break
+    bool lookup(const string& key, string& value) const;
+    // put 'key' with 'value' into the cache (failures are silently ignored, the cache is just slower then)
+    void store(const string& key, const string& value) const;
+  };
+
+  // a fingerprint of the running program: a hash of its executable, so that it changes with every change of the code
+  // (or of the build options), but not when the same code is built again; empty if the executable cannot be read
+  string program_fingerprint();
+
+  // a stream buffer passing everything written to it on to two other stream buffers
+  // (to record what is written to cout, let cout write to a tee_buffer of its old buffer and the recorder)
+  class tee_buffer : public streambuf {
+    streambuf* const first;
+    streambuf* const second;
+  protected:
+    int overflow(const int c){
+      if(c == traits_type::eof()) return traits_type::not_eof(c);
+      const int r1 = first->sputc(c), r2 = second->sputc(c);
+      return (r1 == traits_type::eof() || r2 == traits_type::eof()) ? traits_type::eof() : c;
+    }
+    int sync(){
+      const int r1 = first->pubsync(), r2 = second->pubsync();
+      return (r1 == 0 && r2 == 0) ? 0 : -1;
+    }
+  public:
+    tee_buffer(streambuf* const _first, streambuf* const _second): first(_first), second(_second) {}
+  };
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef STRIPED_MAP_HPP
+#define STRIPED_MAP_HPP
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "defs.hpp"
+
+using namespace std;
+
+namespace vc {
+
+  // a hash map that many threads can update concurrently: the keys are distributed over
+  // 'num_stripes' independent maps, each protected by its own lock, so two threads only
+  // wait for each other if they happen to hit the same stripe at the same time
+  template<class Key, class Value, class Hash = hash<Key>, uint num_stripes = 64>
+  class striped_map {
+    // keep the stripes on different cache lines, so their locks don't interfere
+    struct alignas(64) stripe {
+      mutex lock;
+      unordered_map<Key, Value, Hash> entries;
+    };
+
+    stripe stripes[num_stripes];
+    Hash hasher;
+
+    // the maps of the stripes use the low bits of the hash, so choose the stripe by the high bits
+    inline stripe& get_stripe(const Key& key) {
+      return stripes[((uint64_t)hasher(key) * 0x9E3779B97F4A7C15ull >> 32) % num_stripes];
+    }
+  public:
+    // call f on the value of 'key' (a new, default constructed one if 'key' is not in the map)
+    // while holding the lock of its stripe
+    template<class Function>
+    void update(const Key& key, const Function& f){
+      stripe& s(get_stripe(key));
+      lock_guard<mutex> guard(s.lock);
+      f(s.entries[key]);
+    }
+
+    // move all entries out of the map, leaving it empty
+    // (don't call this while other threads are updating the map)
+    vector<pair<Key, Value> > extract(){
+      vector<pair<Key, Value> > result;
+      for(uint i = 0; i < num_stripes; ++i){
+        for(auto& entry : stripes[i].entries)
+          result.push_back(make_pair(entry.first, move(entry.second)));
+        stripes[i].entries.clear();
+      }
+      return result;
+    }
+  };
+
+}
+
+#endif
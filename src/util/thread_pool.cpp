@@ -0,0 +1,122 @@
+#include "thread_pool.hpp"
+#include <chrono>
+
+namespace vc {
+
+  // the pool whose worker is running this thread, and the index of this worker
+  static thread_local const thread_pool* current_pool = NULL;
+  static thread_local uint current_index = 0;
+
+  thread_pool::thread_pool(const uint num_threads): queued(0), next_queue(0), stopping(false) {
+    for(uint i = 0; i < num_threads; ++i)
+      queues.push_back(unique_ptr<task_queue>(new task_queue()));
+    for(uint i = 0; i < num_threads; ++i)
+      workers.push_back(thread(&thread_pool::work, this, i));
+  }
+
+  thread_pool::~thread_pool(){
+    {
+      lock_guard<mutex> lock(sleep_mutex);
+      stopping = true;
+    }
+    tasks_available.notify_all();
+    for(thread& t : workers) t.join();
+  }
+
+  uint thread_pool::my_index() const{
+    return (current_pool == this) ? current_index : size();
+  }
+
+  bool thread_pool::get_task(const uint index, function<void()>& task){
+    const uint num_queues = queues.size();
+    // first, look at our own queue
+    if(index < num_queues){
+      task_queue& q(*queues[index]);
+      lock_guard<mutex> lock(q.tasks_mutex);
+      if(!q.tasks.empty()){
+        task = q.tasks.back();
+        q.tasks.pop_back();
+        --queued;
+        return true;
+      }
+    }
+    // then, try to steal from the others
+    for(uint offset = 1; offset <= num_queues; ++offset){
+      task_queue& q(*queues[(index + offset) % num_queues]);
+      lock_guard<mutex> lock(q.tasks_mutex);
+      if(!q.tasks.empty()){
+        task = q.tasks.front();
+        q.tasks.pop_front();
+        --queued;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void thread_pool::work(const uint index){
+    current_pool = this;
+    current_index = index;
+    while(true){
+      function<void()> task;
+      if(get_task(index, task)){
+        task();
+        continue;
+      }
+      unique_lock<mutex> lock(sleep_mutex);
+      while(!stopping && queued == 0) tasks_available.wait(lock);
+      if(stopping && queued == 0) return; // stopping and nothing left to do
+    }
+  }
+
+  void thread_pool::submit(const function<void()>& task){
+    uint index = my_index();
+    if(index == size()) index = next_queue++ % size();
+    // count the task before it becomes visible, so 'queued' never drops below zero
+    {
+      lock_guard<mutex> lock(sleep_mutex);
+      ++queued;
+    }
+    {
+      task_queue& q(*queues[index]);
+      lock_guard<mutex> lock(q.tasks_mutex);
+      q.tasks.push_back(task);
+    }
+    tasks_available.notify_one();
+  }
+
+  bool thread_pool::run_pending_task(){
+    function<void()> task;
+    if(!get_task(my_index(), task)) return false;
+    task();
+    return true;
+  }
+
+
+  void task_group::run(const function<void()>& task){
+    {
+      lock_guard<mutex> lock(pending_mutex);
+      ++pending;
+    }
+    pool.submit([this, task](){
+        task();
+        lock_guard<mutex> lock(pending_mutex);
+        if(--pending == 0) all_done.notify_all();
+      });
+  }
+
+  void task_group::wait(){
+    while(true){
+      {
+        unique_lock<mutex> lock(pending_mutex);
+        if(!pending) return;
+      }
+      if(!pool.run_pending_task()){
+        // nothing to help with, so wait a bit for our tasks (new tasks might show up in the meantime)
+        unique_lock<mutex> lock(pending_mutex);
+        if(pending) all_done.wait_for(lock, chrono::milliseconds(1));
+      }
+    }
+  }
+
+}
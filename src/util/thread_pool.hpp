@@ -0,0 +1,77 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "defs.hpp"
+
+using namespace std;
+
+namespace vc {
+
+  // a fixed number of worker threads executing tasks in a work-stealing fashion:
+  // each worker has its own deque of tasks, it takes its newest task from the back
+  // and, if it has nothing to do, steals the oldest task from the front of another worker's deque
+  class thread_pool {
+    struct task_queue {
+      deque<function<void()> > tasks;
+      mutex tasks_mutex;
+    };
+
+    vector<thread> workers;
+    vector<unique_ptr<task_queue> > queues;
+    // number of tasks in all queues
+    atomic<uint> queued;
+    // tasks submitted from outside the pool are distributed round-robin
+    atomic<uint> next_queue;
+    mutex sleep_mutex;
+    condition_variable tasks_available;
+    bool stopping;
+
+    // main loop of worker 'index': run tasks until the pool is stopped
+    void work(const uint index);
+    // get a task from the back of queue 'index' or steal one from the front of any other queue
+    bool get_task(const uint index, function<void()>& task);
+    // index of the worker of this pool running the calling thread (or size() if it's not one of ours)
+    uint my_index() const;
+  public:
+    thread_pool(const uint num_threads);
+    // finish all pending tasks and join the workers
+    ~thread_pool();
+
+    // tasks submitted by a worker go to its own queue
+    void submit(const function<void()>& task);
+    // run one pending task on the calling thread, if there is any
+    bool run_pending_task();
+    inline uint size() const { return workers.size(); }
+    // whether there are less pending tasks than workers, so some worker might be idle
+    inline bool hungry() const { return queued < workers.size(); }
+  };
+
+  // a set of tasks running on a pool, which can be waited for
+  class task_group {
+    thread_pool& pool;
+    uint pending;
+    mutex pending_mutex;
+    condition_variable all_done;
+  public:
+    task_group(thread_pool& _pool): pool(_pool), pending(0) {}
+    // wait for all tasks, since they might refer to local variables of the creator of the group
+    ~task_group() { wait(); }
+
+    void run(const function<void()>& task);
+    // block until all tasks of the group have finished, helping out with pending tasks in the meantime
+    // (so tasks can wait for tasks they spawned without starving the pool)
+    void wait();
+  };
+
+}
+
+#endif